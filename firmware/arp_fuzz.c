@@ -0,0 +1,267 @@
+/*********************************************************************/
+/*                   Arpeggiator fuzzer (HAL_HOST build)             */
+/* Turns each input into a run of control events, transport flags    */
+/* and Timer0 ticks fed to the firmware on the simulated clock of    */
+/* hal_host.c, every input from power on (hal_reset(), arp_init()),  */
+/* and aborts as soon as an invariant breaks:                        */
+/*  - controls stay inside the limits of set_control(), octave below */
+/*    9 and octave + steps at most 9, the tempo inside TEMPO_MIN -   */
+/*    TEMPO_MAX                                                      */
+/*  - the MUSIC_CHECK()s in music.c: the arpeggio position wraps from*/
+/*    -1 into key[8], the runs stay inside steps, a compiled arpeggio*/
+/*    fits the step buffer and playback stays inside it              */
+/*  - every note played (note_trace()) is below NUM_NOTES, has a     */
+/*    duration, and leaves a nonzero count in its OCR and a          */
+/*    prescaler clock select, never an external clock (TONE_ISR and  */
+/*    TONE_HW builds)                                                */
+/*                                                                   */
+/* Built with -DLIBFUZZER (make fuzz-lf, clang) it is a libFuzzer    */
+/* target. Otherwise (make fuzz) main() runs random inputs, or the   */
+/* input files named on the command line, which also makes it an AFL */
+/* target when built with HOST_CC=afl-clang-fast:                    */
+/*  arp-fuzz [-n inputs] [-s seed] [file...]                         */
+/*                                                                   */
+/* Input, two bytes an operation, op then arg. The low 3 bits of op  */
+/* pick what to do, the next 2 the channel:                          */
+/*  0 EV_NOTES arg       1 EV_PARAM arg      2 EV_SET arg            */
+/*  3 EV_SYNC, on channels 1-3 music_scale_user(arg << 4 | op >> 4)  */
+/*  4 pattern_start() (arg odd) or pattern_stop(), on channels 1-3   */
+/*    pattern_length(arg)                                            */
+/*  5 pattern step op >> 3 = keys arg, flags the next byte           */
+/*  6 run (arg & 63) + 1 Timer0 ticks                                */
+/*  7 music_tempo() from arg, EV_TEMPO arg with op bit 7 set, on     */
+/*    channels 1-3 music_tuning(arg)                                 */
+/*********************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "hal.h"
+#include "arpeggiator.h"
+#include "music.h"
+#include "event.h"
+#include "pattern.h"
+#ifdef TONE_DDS
+#include "synth.h"
+#endif
+
+#define FUZZ_TICK (F_CPU / CLOCK_HZ)
+
+static uint32_t played;    //notes and rests, over every input
+static uint64_t simulated; //CPU cycles, over every input
+
+static void fail(const char *what, int value)
+{
+   fprintf(stderr, "arp-fuzz: %s (%d)\n", what, value);
+   abort();
+}
+
+void music_check_failed(const char *cond, int line)
+{
+   fprintf(stderr, "arp-fuzz: music.c:%d: MUSIC_CHECK(%s)\n", line, cond);
+   abort();
+}
+
+void note_trace(const note_event_t *e)
+{
+   played++;
+   if (e->channel >= ARP_CHANNELS)
+      fail("step on a channel that does not exist", e->channel);
+   if (e->flags)
+      return;
+   if (e->note >= NUM_NOTES)
+      fail("note past B8", e->note);
+   if (e->duration == 0)
+      fail("note without a duration", e->note);
+#ifndef TONE_DDS
+   if ((e->channel == 0 ? OCR1A : OCR3A) == 0)
+      fail("note left the tone timer at 0", e->note);
+   if (((e->channel == 0 ? TCCR1B : TCCR3B) & 0x07) > 5)
+      fail("note clocks the tone timer from its pin", e->note);
+#endif
+}
+
+//the controls every path into music_update() has to respect
+static void check(void)
+{
+   uint8_t ch;
+
+   if (switch_ch < 1 || switch_ch > ARP_CHANNELS)
+      fail("switch_ch", switch_ch);
+   for (ch = 0; ch < ARP_CHANNELS; ch++)
+   {
+      arp_channel_t *c = &arp[ch];
+
+      if (c->octave > 8)
+         fail("octave", c->octave);
+      if (c->steps < 1 || c->octave + c->steps > 9)
+         fail("steps", c->steps);
+      if (c->rate < 1 || c->rate > 9)
+         fail("rate", c->rate);
+      if (c->type < 1 || c->type > 4)
+         fail("type", c->type);
+      if (c->scale >= NUM_SCALES)
+         fail("scale", c->scale);
+      if (c->root > 11)
+         fail("root", c->root);
+      if (c->step_len < 1 || c->step_len > 16)
+         fail("step_len", c->step_len);
+#ifdef TONE_DDS
+      if (c->wave >= NUM_WAVES)
+         fail("wave", c->wave);
+#endif
+   }
+   if (tempo < TEMPO_MIN || tempo > TEMPO_MAX)
+      fail("tempo", tempo);
+   if (pattern_len < 1 || pattern_len > PATTERN_STEPS)
+      fail("pattern_len", pattern_len);
+   if (pattern_pos >= PATTERN_STEPS)
+      fail("pattern_pos", pattern_pos);
+}
+
+//power on, so an input does the same whatever ran before it and a
+//failing one replays from its file
+static void fuzz_reset(void)
+{
+   event_t ev;
+
+   simulated += hal_cycles;
+   hal_reset();
+   arp_init();
+   while (event_pop(&ev)) //left over from the last input
+      ;
+}
+
+//one input, from power on
+static void fuzz_one(const uint8_t *data, size_t size)
+{
+   uint8_t op, arg, ch;
+   size_t i;
+
+   fuzz_reset();
+   arp_loop();
+   check();
+
+   for (i = 0; i + 1 < size; i += 2)
+   {
+      op = data[i];
+      arg = data[i + 1];
+      ch = (op >> 3) & 0x03;
+      switch (op & 0x07)
+      {
+      case 0:
+         event_push(EV_NOTES | ch, arg);
+         break;
+      case 1:
+         event_push(EV_PARAM | ch, arg);
+         break;
+      case 2:
+         event_push(EV_SET | ch, arg);
+         break;
+      case 3:
+         if (ch)
+            music_scale_user(arg << 4 | op >> 4);
+         else
+            event_push(EV_SYNC, 0);
+         break;
+      case 4:
+         if (ch)
+            pattern_length(arg);
+         else if (arg & 1)
+            pattern_start();
+         else
+            pattern_stop();
+         break;
+      case 5:
+         pattern_set(op >> 3, arg, i + 2 < size ? data[i + 2] : 0);
+         i++;
+         break;
+      case 6:
+         hal_run((arg & 0x3F) * FUZZ_TICK + FUZZ_TICK, arp_loop);
+         break;
+      case 7:
+         if (ch)
+            music_tuning(arg);
+         else if (op & 0x80)
+            event_push(EV_TEMPO, arg);
+         else
+            music_tempo(TEMPO_MIN + arg * 10);
+         break;
+      }
+      arp_loop();
+      check();
+   }
+}
+
+#ifdef LIBFUZZER
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+   fuzz_one(data, size);
+   return 0;
+}
+#else
+#define FUZZ_MAX 256
+
+int main(int argc, char **argv)
+{
+   uint8_t data[FUZZ_MAX];
+   unsigned long inputs = 100000, n;
+   uint32_t seed = 1;
+   size_t size, k;
+   clock_t start;
+   double wall;
+   FILE *f;
+   int opt;
+
+   while ((opt = getopt(argc, argv, "n:s:")) != -1)
+   {
+      switch (opt)
+      {
+      case 'n':
+         inputs = strtoul(optarg, NULL, 0);
+         break;
+      case 's':
+         seed = strtoul(optarg, NULL, 0);
+         break;
+      default:
+         fprintf(stderr, "usage: %s [-n inputs] [-s seed] [file...]\n", argv[0]);
+         return 1;
+      }
+   }
+
+   start = clock();
+   if (optind < argc)
+   { //replay
+      inputs = argc - optind;
+      for (; optind < argc; optind++)
+      {
+         f = fopen(argv[optind], "rb");
+         if (!f)
+         {
+            perror(argv[optind]);
+            return 1;
+         }
+         size = fread(data, 1, sizeof(data), f);
+         fclose(f);
+         fuzz_one(data, size);
+      }
+   }
+   else
+   {
+      srand(seed);
+      for (n = 0; n < inputs; n++)
+      {
+         size = 2 + rand() % (FUZZ_MAX - 1);
+         for (k = 0; k < size; k++)
+            data[k] = rand();
+         fuzz_one(data, size);
+      }
+   }
+   simulated += hal_cycles;
+   wall = (double)(clock() - start) / CLOCKS_PER_SEC;
+   fprintf(stderr, "%lu inputs, %lu steps, %.0f steps/s, %.0fs simulated in %.3fs\n", inputs, (unsigned long)played,
+           wall > 0 ? played / wall : 0.0, simulated / (double)F_CPU, wall);
+   return 0;
+}
+#endif
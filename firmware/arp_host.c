@@ -0,0 +1,62 @@
+/*********************************************************************/
+/*                   Native arpeggiator (HAL_HOST build)             */
+/* Runs the firmware against the simulated clock in hal_host.c, far  */
+/* faster than real time.                                            */
+/*                                                                   */
+/*  arpeggiator_host [-s seconds] [-k keys] [-r regs]                */
+/*    -s  simulated time to run, default 10                          */
+/*    -k  note keys held the whole time, bit n is key n (PINA)       */
+/*    -r  trace these registers to stdout, comma separated, "all"    */
+/*        for every register hal_host.c watches, SPI for the bytes   */
+/*        sent (see hal_trace())                                     */
+/*********************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "hal.h"
+#include "arpeggiator.h"
+
+int main(int argc, char **argv)
+{
+   double seconds = 10.0;
+   const char *regs = NULL;
+   uint8_t keys = 0;
+   clock_t start;
+   double wall;
+   int opt;
+
+   while ((opt = getopt(argc, argv, "s:k:r:")) != -1)
+   {
+      switch (opt)
+      {
+      case 's':
+         seconds = atof(optarg);
+         break;
+      case 'k':
+         keys = strtoul(optarg, NULL, 0);
+         break;
+      case 'r':
+         regs = optarg;
+         break;
+      default:
+         fprintf(stderr, "usage: %s [-s seconds] [-k keys] [-r regs]\n", argv[0]);
+         return 1;
+      }
+   }
+
+   arp_init();
+   if (regs)
+      hal_trace(stdout, strcmp(regs, "all") ? regs : NULL);
+
+   //keys are active low, held from the start
+   PINA = ~keys;
+
+   start = clock();
+   hal_run((uint64_t)(seconds * F_CPU), arp_loop);
+   wall = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+   fprintf(stderr, "%.3fs simulated in %.3fs (%.0fx real time)\n", seconds, wall, wall > 0 ? seconds / wall : 0.0);
+   return 0;
+}
@@ -0,0 +1,481 @@
+/*********************************************************************/
+/*                   Offline renderer (HAL_HOST build)               */
+/* Plays a script of key, button and control input into the firmware */
+/* running on the simulated clock of hal_host.c, as fast as the host */
+/* can go, and writes what the speaker would have heard to a WAV.    */
+/*                                                                   */
+/*  arp-render [-o out.wav] [-r rate] [-t out.trace] [-c golden]     */
+/*             script                                                */
+/*    -o  WAV to write, default arp.wav unless -t or -c is given     */
+/*    -r  sample rate, default 44100                                 */
+/*    -t  note trace to write, every step played (see music.h)       */
+/*    -c  note trace to compare against, exits 2 at the first step   */
+/*        that differs                                               */
+/*    script  "-" reads it from stdin                                */
+/*                                                                   */
+/* Script, one input per line, # starts a comment:                   */
+/*  <seconds> keys <mask>       note keys held from then on (PINA)   */
+/*  <seconds> channel <n>       channel button until n is selected   */
+/*  <seconds> set <n> <control> <value>                              */
+/*                              control of channel n outright, one of*/
+/*                              root steps rate octave type scale    */
+/*                              length wave                          */
+/*  <seconds> userscale <mask>  semitone mask of the user scale      */
+/*  <seconds> tuning <n>        music_tuning(), see tunings.c        */
+/*  <seconds> save|delete       channel 1 save/delete buttons        */
+/*  <seconds> seq <1-4>         sequence button, records a step      */
+/*                              (see record_step())                  */
+/*  <seconds> step <n> <keys> <flags>                                */
+/*                              pattern step n (0 based) outright,   */
+/*                              flags as in pattern.h                */
+/*  <seconds> pattern <len>     pattern length in steps              */
+/*  <seconds> play|stop         sequencer transport buttons          */
+/*  <seconds> tempo <bpm>       music_tempo(), may have a fraction   */
+/*  <seconds> end               last sample, else 1s after the last  */
+/*                              input                                */
+/* Lines run in order, a button press holds the simulated clock for  */
+/* RENDER_PRESS Timer0 ticks so a line timed inside one runs late.   */
+/*                                                                   */
+/* Audio: TONE_ISR builds mix the square waves on PORTD pins 7 and 6,*/
+/* TONE_HW builds the OC1C/OC3A compare outputs (not simulated by    */
+/* hal_host.c, rebuilt here from OCR1A/OCR3A and the COM bits) and   */
+/* TONE_DDS builds the Timer3 PWM duty. Each sample is the mean level */
+/* over its period, then a DC blocker takes out the offset.          */
+/*                                                                   */
+/* Note traces are 8 bytes a step, little endian: beat (4), channel, */
+/* note, duration, flags. Recording one before a refactor of the     */
+/* arpeggiate functions and replaying the same script with -c after  */
+/* proves the notes did not change. golden/ keeps a few scripts and  */
+/* the traces recorded from them for each variant, make check        */
+/* replays them against the traces and make golden records them.     */
+/*********************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "hal.h"
+#include "arpeggiator.h"
+#include "music.h"
+#include "event.h"
+#include "pattern.h"
+
+//Timer0 ticks a button is held, longer than the debounce in arpeggiator.c
+#define RENDER_PRESS 16
+#define RENDER_TICK (F_CPU / CLOCK_HZ)
+#define RENDER_GAIN 0.7
+
+//output level between register changes and the sample being built
+static double level;
+static double t_last;     //cycle the level has been integrated up to
+static double t_sample;   //cycle the current sample ends on
+static double per_sample; //cycles per sample
+static double acc;
+static double dc_in, dc_out;
+static FILE *wav;
+static uint32_t samples;
+
+//note traces, see note_trace()
+#define TRACE_BYTES 8
+static FILE *trace_out, *golden;
+static uint32_t trace_n;
+static uint8_t trace_differs;
+
+#ifdef TONE_HW
+//a compare output toggling every period cycles while on
+typedef struct
+{
+   uint8_t on;
+   uint8_t pin;
+   uint32_t period;
+   double next; //cycle of the next toggle
+} render_osc_t;
+
+static render_osc_t osc[2];
+#endif
+
+static void write16(uint16_t v)
+{
+   fputc(v & 0xFF, wav);
+   fputc(v >> 8, wav);
+}
+
+static void write32(uint32_t v)
+{
+   write16(v & 0xFFFF);
+   write16(v >> 16);
+}
+
+static void wav_header(uint32_t rate, uint32_t n)
+{
+   fwrite("RIFF", 1, 4, wav);
+   write32(36 + n * 2);
+   fwrite("WAVEfmt ", 1, 8, wav);
+   write32(16);
+   write16(1); //PCM
+   write16(1); //mono
+   write32(rate);
+   write32(rate * 2);
+   write16(2);
+   write16(16);
+   fwrite("data", 1, 4, wav);
+   write32(n * 2);
+}
+
+//finishes the current sample
+static void emit(void)
+{
+   double x = acc / per_sample, y;
+   long s;
+
+   //one pole high pass, the square waves idle at either rail
+   y = x - dc_in + 0.995 * dc_out;
+   dc_in = x;
+   dc_out = y;
+   s = (long)(y * RENDER_GAIN * 32767.0);
+   if (s > 32767)
+      s = 32767;
+   if (s < -32768)
+      s = -32768;
+   if (wav)
+      write16((uint16_t)s);
+   samples++;
+   acc = 0;
+}
+
+//integrates the current level up to cycle t
+static void integrate(double t)
+{
+   while (t >= t_sample)
+   {
+      acc += level * (t_sample - t_last);
+      t_last = t_sample;
+      emit();
+      t_sample += per_sample;
+   }
+   acc += level * (t - t_last);
+   t_last = t;
+}
+
+#ifdef TONE_HW
+static void osc_level(void)
+{
+   level = (osc[0].pin + osc[1].pin) / 2.0;
+}
+
+//integrates up to cycle t, toggling the compare outputs on the way
+static void advance(double t)
+{
+   render_osc_t *o;
+
+   for (;;)
+   {
+      o = NULL;
+      if (osc[0].on && osc[0].next <= t)
+         o = &osc[0];
+      if (osc[1].on && osc[1].next <= t && (!o || osc[1].next < o->next))
+         o = &osc[1];
+      if (!o)
+         break;
+      integrate(o->next);
+      o->pin ^= 1;
+      o->next += o->period;
+      osc_level();
+   }
+   integrate(t);
+}
+
+//a compare output is running while its COM bit is set and its clock on
+static void osc_update(render_osc_t *o, uint8_t on, uint16_t ocr, uint8_t cs)
+{
+   static const uint16_t prescale[8] = {0, 1, 8, 64, 256, 1024, 0, 0};
+   uint32_t period = (ocr + 1UL) * prescale[cs & 0x07];
+
+   on = on && period;
+   if (on && (!o->on || period != o->period))
+      o->next = hal_cycles + period; //CTC counts from here to the new top
+   o->on = on;
+   o->period = period;
+}
+
+static void hook(volatile void *reg, uint16_t value)
+{
+   advance(hal_cycles);
+   osc_update(&osc[0], TCCR1A & (1 << COM1C0), OCR1A, TCCR1B);
+   osc_update(&osc[1], TCCR3A & (1 << COM3A0), OCR3A, TCCR3B);
+}
+#else
+static void advance(double t)
+{
+   integrate(t);
+}
+
+static void hook(volatile void *reg, uint16_t value)
+{
+   advance(hal_cycles);
+#ifdef TONE_DDS
+   //8-bit fast PWM, the duty is the level
+   if (reg == &OCR3A)
+      level = value / 255.0;
+#else
+   if (reg == &PORTD)
+      level = (((value >> PD7) & 1) + ((value >> PD6) & 1)) / 2.0;
+#endif
+}
+#endif
+
+/*********************************************************************/
+/*                             note_trace                            */
+/*Called by next_step() for every step played (NOTE_TRACE), writes   */
+/*it to the -t trace and checks it against the -c one                */
+/*********************************************************************/
+
+static void trace_print(const char *what, const uint8_t *b)
+{
+   fprintf(stderr, "  %s: beat %lu channel %u note %u duration %u flags %u\n", what,
+           (unsigned long)(b[0] | b[1] << 8 | b[2] << 16 | (uint32_t)b[3] << 24), b[4] + 1, b[5], b[6], b[7]);
+}
+
+void note_trace(const note_event_t *e)
+{
+   uint8_t b[TRACE_BYTES], g[TRACE_BYTES];
+
+   b[0] = e->beat;
+   b[1] = e->beat >> 8;
+   b[2] = e->beat >> 16;
+   b[3] = e->beat >> 24;
+   b[4] = e->channel;
+   b[5] = e->note;
+   b[6] = e->duration;
+   b[7] = e->flags;
+   if (trace_out)
+      fwrite(b, 1, TRACE_BYTES, trace_out);
+   if (golden && !trace_differs)
+   {
+      if (fread(g, 1, TRACE_BYTES, golden) != TRACE_BYTES)
+      {
+         fprintf(stderr, "step %lu is past the end of the golden trace\n", (unsigned long)trace_n);
+         trace_print("got", b);
+         trace_differs = 1;
+      }
+      else if (memcmp(b, g, TRACE_BYTES))
+      {
+         fprintf(stderr, "step %lu differs\n", (unsigned long)trace_n);
+         trace_print("expected", g);
+         trace_print("got", b);
+         trace_differs = 1;
+      }
+   }
+   trace_n++;
+}
+
+//runs the firmware up to cycle t, the renderer follows through hook()
+static void run_to(uint64_t t)
+{
+   if (t > hal_cycles)
+      hal_run(t - hal_cycles, arp_loop);
+   advance(hal_cycles);
+}
+
+//holds a button down long enough to count as a press, then lets go
+static void press(volatile uint8_t *pin, uint8_t bit)
+{
+   *pin &= ~(1 << bit);
+   run_to(hal_cycles + RENDER_PRESS * RENDER_TICK);
+   *pin |= 1 << bit;
+   run_to(hal_cycles + 2 * RENDER_TICK);
+}
+
+//attribute number of a control, -1 for none
+static int control(const char *name)
+{
+   static const char *names[] = {"root", "steps", "rate", "octave", "type", "scale", "length", "wave"};
+   int i;
+
+   for (i = 0; i < 8; i++)
+      if (!strcmp(name, names[i]))
+         return i;
+   return -1;
+}
+
+//runs one script line, returns 0 for end, -1 for a bad line
+static int command(uint64_t t, char *cmd, char *a, char *b, char *c)
+{
+   int n;
+
+   run_to(t);
+   if (!strcmp(cmd, "keys") && a)
+      PINA = ~strtoul(a, NULL, 0); //active low
+   else if (!strcmp(cmd, "channel") && a)
+   {
+      n = atoi(a);
+      if (n < 1 || n > ARP_CHANNELS)
+         return -1;
+      while (switch_ch != n)
+         press(&PINC, 2);
+   }
+   else if (!strcmp(cmd, "set") && c)
+   {
+      n = atoi(a);
+      if (n < 1 || n > ARP_CHANNELS || control(b) < 0)
+         return -1;
+      event_push(EV_SET | (n - 1), EV_SET_VALUE(control(b), atoi(c)));
+   }
+   else if (!strcmp(cmd, "userscale") && a)
+      music_scale_user(strtoul(a, NULL, 0));
+   else if (!strcmp(cmd, "tuning") && a)
+      music_tuning(atoi(a));
+   else if (!strcmp(cmd, "save"))
+      press(&PINC, 0);
+   else if (!strcmp(cmd, "delete"))
+      press(&PINC, 1);
+   else if (!strcmp(cmd, "seq") && a && atoi(a) >= 1 && atoi(a) <= 4)
+      press(&PINF, atoi(a) - 1);
+   else if (!strcmp(cmd, "step") && c)
+   {
+      n = atoi(a);
+      if (n < 0 || n >= PATTERN_STEPS)
+         return -1;
+      pattern_set(n, strtoul(b, NULL, 0), strtoul(c, NULL, 0));
+   }
+   else if (!strcmp(cmd, "pattern") && a)
+      pattern_length(atoi(a));
+   else if (!strcmp(cmd, "play"))
+      press(&PINF, 4);
+   else if (!strcmp(cmd, "stop"))
+      press(&PINF, 5);
+   else if (!strcmp(cmd, "tempo") && a)
+   {
+      n = (int)(atof(a) * 10 + 0.5);
+      if (n < TEMPO_MIN || n > TEMPO_MAX)
+         return -1;
+      music_tempo(n);
+   }
+   else if (!strcmp(cmd, "end"))
+      return 0;
+   else
+      return -1;
+   return 1;
+}
+
+int main(int argc, char **argv)
+{
+   const char *out = NULL, *trace_name = NULL, *golden_name = NULL;
+   uint32_t rate = 44100;
+   char line[256], *p, *cmd, *a, *b, *c;
+   double seconds;
+   uint64_t end = 0;
+   unsigned lineno = 0;
+   FILE *script;
+   clock_t start;
+   double wall;
+   int opt, r = 1;
+
+   while ((opt = getopt(argc, argv, "o:r:t:c:")) != -1)
+   {
+      switch (opt)
+      {
+      case 'o':
+         out = optarg;
+         break;
+      case 'r':
+         rate = strtoul(optarg, NULL, 0);
+         break;
+      case 't':
+         trace_name = optarg;
+         break;
+      case 'c':
+         golden_name = optarg;
+         break;
+      default:
+         optind = argc;
+         break;
+      }
+   }
+   if (optind != argc - 1 || !rate)
+   {
+      fprintf(stderr, "usage: %s [-o out.wav] [-r rate] [-t out.trace] [-c golden] script\n", argv[0]);
+      return 1;
+   }
+   script = strcmp(argv[optind], "-") ? fopen(argv[optind], "r") : stdin;
+   if (!script)
+   {
+      perror(argv[optind]);
+      return 1;
+   }
+   if (!out && !trace_name && !golden_name)
+      out = "arp.wav";
+   if (out)
+   {
+      wav = fopen(out, "wb");
+      if (!wav)
+      {
+         perror(out);
+         return 1;
+      }
+      wav_header(rate, 0); //sizes filled in at the end
+   }
+   if (trace_name && !(trace_out = fopen(trace_name, "wb")))
+   {
+      perror(trace_name);
+      return 1;
+   }
+   if (golden_name && !(golden = fopen(golden_name, "rb")))
+   {
+      perror(golden_name);
+      return 1;
+   }
+
+   per_sample = (double)F_CPU / rate;
+   t_sample = per_sample;
+   start = clock();
+   arp_init();
+   hal_hook(hook);
+
+   while (r > 0 && fgets(line, sizeof(line), script))
+   {
+      lineno++;
+      if ((p = strchr(line, '#')))
+         *p = '\0';
+      p = strtok(line, " \t\r\n");
+      if (!p)
+         continue;
+      seconds = atof(p);
+      cmd = strtok(NULL, " \t\r\n");
+      a = strtok(NULL, " \t\r\n");
+      b = a ? strtok(NULL, " \t\r\n") : NULL;
+      c = b ? strtok(NULL, " \t\r\n") : NULL;
+      end = (uint64_t)(seconds * F_CPU);
+      if (!cmd || seconds < 0 || (r = command(end, cmd, a, b, c)) < 0)
+      {
+         fprintf(stderr, "%s:%u: bad line\n", argv[optind], lineno);
+         return 1;
+      }
+   }
+   if (r > 0) //no end line
+      end = (end > hal_cycles ? end : hal_cycles) + F_CPU;
+   run_to(end);
+
+   wall = (double)(clock() - start) / CLOCKS_PER_SEC;
+   if (wav)
+   {
+      fseek(wav, 0, SEEK_SET);
+      wav_header(rate, samples);
+      fclose(wav);
+   }
+   if (trace_out)
+      fclose(trace_out);
+   fprintf(stderr, "%s: %.3fs rendered in %.3fs (%.0fx real time), %lu steps\n", argv[optind], (double)samples / rate, wall,
+           wall > 0 ? (double)samples / rate / wall : 0.0, (unsigned long)trace_n);
+   if (golden)
+   {
+      if (!trace_differs && fgetc(golden) != EOF)
+      {
+         fprintf(stderr, "the golden trace has more than %lu steps\n", (unsigned long)trace_n);
+         trace_differs = 1;
+      }
+      if (trace_differs)
+         return 2;
+   }
+   return 0;
+}
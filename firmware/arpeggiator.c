@@ -4,17 +4,38 @@
  *************************************/
 #define TRUE 0x01
 #define FALSE 0x00
-#include <avr/io.h>
-#include <util/delay.h>
-#include <avr/interrupt.h>
 #include <stdlib.h>
+#include "hal.h"
+#include "arpeggiator.h"
 #include "music.h"
+#include "synth.h"
+#include "event.h"
+#include "pattern.h"
+#include "spi.h"
+#include "profile.h"
+#ifdef BENCH
+#include <avr/eeprom.h>
+#include "bench.h"
+#endif
 
 //Count stores the value displayed to the seven seg
 uint16_t count;
 
-//The previous state of the encoders
-uint8_t prev;
+//quadrature decoder state of one encoder
+typedef struct
+{
+	uint8_t ab;	  //last A/B reading
+	int8_t quarter; //quarter steps since the last detent
+	uint8_t idle;	  //Timer0 ticks since the last detent
+} encoder_t;
+
+//left encoder picks the attribute, right encoder changes it, both start
+//resting on a detent
+encoder_t enc_left = {0b11, 0, 255};
+encoder_t enc_right = {0b11, 0, 255};
+
+//last 74HC165 reading, the left encoder is bits 0-1, the right bits 2-3
+volatile uint8_t encoder_val = 0x0F;
 
 //holds data to be sent to the segments. logic zero turns a digit on
 uint8_t segment_data[5];
@@ -22,14 +43,40 @@ uint8_t segment_data[5];
 //The the current digit
 uint8_t digit_to_display;
 
+//main loop load, main_busy is sampled on every display tick and
+//idle_percent is updated once every IDLE_WINDOW ticks (about a second)
+#define IDLE_WINDOW 1024
+volatile uint8_t main_busy;
+volatile uint8_t idle_percent;
+
+#ifdef ISR_PROFILE
+volatile uint8_t isr_max; //see profile.h
+#endif
+
+//raw input snapshots, written by the Timer0 ISR and read by input_task()
+#define INPUT_SAMPLES 8 //a power of two
+typedef struct
+{
+	uint8_t pina; //keys
+	uint8_t pinc; //save, delete, channel
+	uint8_t pinf; //sequence buttons
+	uint8_t encoders;
+} input_sample_t;
+input_sample_t input_buf[INPUT_SAMPLES];
+volatile uint8_t input_head; //Timer0 only
+volatile uint8_t input_tail; //input_task() only
+
 //The on each loop iteration we simply write the value at a particular index out to PORTA
 uint8_t segment_codes[10] = {0xC0, 0xF9, 0xA4, 0xB0, 0x99, 0x92, 0x82, 0xF8, 0x80, 0x90};
 
 //These are the encodings for the value to be written to PORTB, index 0 is digit zero etc etc
 uint8_t digit_select[5] = {0x00, 0x10, 0x20, 0x30, 0x40};
 
-//sequence global
-uint8_t repeat_counter;
+//PORTC channel LED colors, indexed by switch_ch - 1
+#if ARP_CHANNELS > 4
+#error "only four channels have an LED color"
+#endif
+uint8_t channel_leds[4] = {(1 << PC7) | (1 << PC5), (1 << PC6) | (1 << PC5), (1 << PC7) | (1 << PC6), (1 << PC5)};
 
 /***********************************************************************/
 //                              tcnt0_init
@@ -50,10 +97,18 @@ void tcnt0_init(void)
  *			The OC2 register is PORTB bit 7. This output
  *			will feed the PWM input of the LED display for 
  *			calibrating brightness using the CdS cell. 
+ *			The overflow interrupt (clk/64, ~977Hz) scans
+ *			the display, so every digit gets one whole PWM
+ *			period.
 ***********************************************************************/
 void tcnt2_init(void)
 {
-	TCCR2 = (1 << WGM21) | (1 << WGM20) | (1 << COM21) | (1 << COM20) | (1 << CS20); // | (1<<CS21);
+#ifdef TONE_HW
+	TCCR2 = (1 << WGM21) | (1 << WGM20) | (1 << CS21) | (1 << CS20); //OC2 pin is carrying the channel 1 tone (OC1C)
+#else
+	TCCR2 = (1 << WGM21) | (1 << WGM20) | (1 << COM21) | (1 << COM20) | (1 << CS21) | (1 << CS20);
+#endif
+	TIMSK |= (1 << TOIE2); //display scan
 																					 //set OCR2 to 0 (bottom) for 100% duty cycle, Fast-PWM, inverting mode, Clk/32 prescale
 																					 //recall that the PWM input of the LED display is tied to a PN transistor, the longer the PWM output for uc
 																					 //is low the brighter the display
@@ -92,80 +147,119 @@ void tcnt3_init(void)
 }
 
 /***********************************************************************/
-//                            spi_init
-//Initalizes the SPI port on the mega128. Does not do any further
-//external device specific initalizations.  Sets up SPI to be:
-//master mode, clock=clk/2, cycle half phase, low polarity, MSB first
-//interrupts disabled, poll SPIF bit in SPSR to check xmit completion
+//                            encoder SPI callbacks
+//The 74HC165 holding both encoders is read with spi_transfer(), these
+//run around the byte.
+//Connections:
+//	CLK_INH:	PORTE, bit 6
+//	SHIFT_LD_N: 	PORTE, bit 5
 /***********************************************************************/
-void spi_init(void)
+void encoder_load(void)
 {
-	SPCR |= (1 << SPE) | (1 << MSTR); //enable SPI, master mode
-	SPSR |= (1 << SPI2X);			  // double speed operation
+	PORTE |= (1 << PE6); //parallel load the 74HC165, write a 1 to CLK_INH and a 0 to SHIFT_LD_N
+	PORTE &= ~(1 << PE5);
+	PORTE &= ~(1 << PE6);
+	PORTE |= (1 << PE5); //enable shift mode reactivate CLK, CLK_ING = 0 and SHIFT_LD_N = 1
 }
 
-/*********************************************************************/
-// spi_read
-//Reads the SPI port.
-/*********************************************************************/
-uint8_t spi_read(void)
+void encoder_done(uint8_t in)
 {
-	SPDR = 0x00; //"dummy" write to SPDR
-	while (bit_is_clear(SPSR, SPIF))
-	{
-	}			   //wait till 8 clock cycles are done
-	return (SPDR); //return incoming data from SPDR
+	encoder_val = in;
+	PORTE |= (1 << PE6); //disable this slave device so we can write to bar graph
 }
 
 /****************************************************************************/
-//                            chk_buttons
-//Checks the state of the button number passed to it. It shifts in ones till
-//the button is pushed. Function returns a 1 only once per debounced button
-//push so a debounce and toggle function can be implemented at the same time.
-//Adapted to check all buttons from Ganssel's "Guide to Debouncing"
-//Expects active low pushbuttons on PINA port.  Debounce time is determined by
-//external loop delay times 12.
+//                            debounce
+//Debounces all 8 pins of an active low pushbutton port at once. Each pin has
+//a 4-bit counter stored "vertically", bit k of every pin's count lives in
+//cnt[k], so one pass of byte wide logic steps all eight counters. A pin has
+//to read pressed DEBOUNCE_TICKS times in a row before it counts as held, the
+//same 12 Timer0 ticks as Ganssle's shift register version in "Guide to
+//Debouncing" that this replaces. A release is taken straight away.
+//On return d->held has the pins held down, d->press the ones that went down
+//on this call and d->release the ones that came up.
 /*****************************************************************************/
-int8_t chk_buttons(uint8_t buttons)
+#define DEBOUNCE_TICKS 12
+#if DEBOUNCE_TICKS < 1 || DEBOUNCE_TICKS > 15
+#error "DEBOUNCE_TICKS has to fit the 4-bit counters"
+#endif
+
+typedef struct
 {
-	static uint16_t state[8] = {0, 0, 0, 0, 0, 0, 0, 0}; //holds present state
-	state[buttons] = (state[buttons] << 1) | (!bit_is_clear(PINA, buttons)) | 0xE000;
-	if (state[buttons] == 0xF000)
-	{
-		state[buttons] |= 0x0800;
-		return 1;
-	}
-	return 0;
-}
+	uint8_t held;
+	uint8_t press;
+	uint8_t release;
+	uint8_t cnt[4];
+} debounce_t;
 
-/*****************************************
- *
- *
- *
- *
- *****************************************/
-int8_t chk_buttonsC(uint8_t buttons)
+void debounce(debounce_t *d, uint8_t pins)
 {
-	static uint16_t state[8] = {0, 0, 0, 0, 0, 0, 0, 0}; //holds present state
-	state[buttons] = (state[buttons] << 1) | (!bit_is_clear(PINC, buttons)) | 0xE000;
-	if (state[buttons] == 0xF000)
-		return 1;
-	return 0;
+	uint8_t down = ~pins; //active low
+	uint8_t wait, done, c0, c1, c2, k;
+
+	d->release = d->held & ~down;
+	d->held &= down;
+
+	//pins down but not held yet count up, all the other counters clear
+	wait = down & ~d->held;
+	c0 = d->cnt[0];
+	c1 = d->cnt[1];
+	c2 = d->cnt[2];
+	d->cnt[0] = ~c0 & wait;
+	d->cnt[1] = (c1 ^ c0) & wait;
+	d->cnt[2] = (c2 ^ (c1 & c0)) & wait;
+	d->cnt[3] = (d->cnt[3] ^ (c2 & c1 & c0)) & wait;
+
+	//counters that just reached DEBOUNCE_TICKS, the loop folds away
+	done = wait;
+	for (k = 0; k < 4; k++)
+		done &= (DEBOUNCE_TICKS & (1 << k)) ? d->cnt[k] : ~d->cnt[k];
+	d->press = done;
+	d->held |= done;
 }
 
-/*****************************************
- *
- *
- *
- *
- *****************************************/
-int8_t chk_buttonsF(uint8_t buttons)
+/****************************************************************************/
+//                            encoder_read
+//Decodes one A/B reading of an encoder. Every change of state is looked up
+//in quad_table as a quarter step forwards (+1, clockwise) or backwards, a
+//jump over a state (sampled too slowly) counts as nothing. The quarter steps
+//are summed until the encoder comes back to rest on a detent (0b11), so a
+//detent still counts when up to two of its four steps were missed.
+//Returns 0, or the detent direction scaled by how soon it came after the
+//last one: 4 within ENC_FAST ticks, 2 within ENC_QUICK, otherwise 1.
+/*****************************************************************************/
+#define ENC_FAST 6   //~47ms a detent
+#define ENC_QUICK 12 //~94ms a detent
+
+//indexed by previous << 2 | current, clockwise is 11 -> 10 -> 00 -> 01 -> 11
+const int8_t quad_table[16] = {0, 1, -1, 0, -1, 0, 0, 1, 1, 0, 0, -1, 0, -1, 1, 0};
+
+int8_t encoder_read(encoder_t *e, uint8_t ab)
 {
-	static uint16_t state[8] = {0, 0, 0, 0, 0, 0, 0, 0}; //holds present state
-	state[buttons] = (state[buttons] << 1) | (!bit_is_clear(PINF, buttons)) | 0xE000;
-	if (state[buttons] == 0xF000)
-		return 1;
-	return 0;
+	int8_t n = 0;
+
+	e->quarter += quad_table[(e->ab << 2) | ab];
+	e->ab = ab;
+	if (e->idle < 255)
+		e->idle++;
+
+	if (ab == 0b11)
+	{
+		if (e->quarter >= 2)
+			n = 1;
+		else if (e->quarter <= -2)
+			n = -1;
+		e->quarter = 0;
+	}
+	if (n)
+	{
+		if (e->idle <= ENC_FAST)
+			n *= 4;
+		else if (e->idle <= ENC_QUICK)
+			n *= 2;
+		e->idle = 0;
+	}
+	return n;
 }
 
 /*****************************************
@@ -198,6 +292,9 @@ uint8_t display_pattern(uint8_t display_seq3[], uint8_t display_seq4[], uint8_t
 //takes a 16-bit binary input value and places the appropriate equivalent 4 digit
 //BCD segment code in the array segment_data for display.
 //array is loaded at exit as:  |digit3|digit2|colon|digit1|digit0|
+//the value is digit0, or digit1-digit0 from 10 up, the attribute indicator
+//is digit1, or digit2 when the value takes two digits. From 100 up (the
+//tempo) the value takes digit2 too and the indicator moves to digit3
 //***********************************************************************************
 
 //uint8_t segment_codes[10] = {0xC0, 0xF9, 0xA4, 0xB0, 0x99, 0x92, 0x82, 0xF8, 0x80, 0x90};
@@ -235,6 +332,8 @@ void segsum(uint16_t sum, uint8_t colon, uint8_t attribute, uint8_t channel, uin
 	static uint8_t *displays4[9] = {dis1_4, dis2_4, dis3_4, dis4_4, dis4_4, dis5_4, dis5_4, dis6_4, dis6_4};
 	static uint8_t dis_lengths[9] = {8, 14, 12, 10, 10, 8, 8, 8, 8};
 
+	uint8_t letter = 0xFF;
+
 	segment_data[0] = segment_codes[sum % 10];
 
 	//set colon
@@ -243,23 +342,32 @@ void segsum(uint16_t sum, uint8_t colon, uint8_t attribute, uint8_t channel, uin
 	//set attribute indicator
 	switch (attribute)
 	{
+	case 0:
+		letter = 0x2F; //r
+		break;
 	case 1:
-		segment_data[1] = 0x12; //0x92;
+		letter = 0x12; //0x92;
 		break;
 	case 2:
-		segment_data[1] = 0x4C; //0xCC;
+		letter = 0x4C; //0xCC;
 		break;
 	case 3:
-		segment_data[1] = 0x40; //0xC0;
+		letter = 0x40; //0xC0;
 		break;
 	case 4:
-		segment_data[1] = 0x08; //A
+		letter = 0x08; //A
 		break;
 	case 5:
-		segment_data[1] = 0x18; //A				//display: Dp,G,F,E,D,C,B,A
+		letter = 0x18; //A				//display: Dp,G,F,E,D,C,B,A
 		break;
 	case 6:
-		segment_data[1] = 0x47; //L
+		letter = 0x47; //L
+		break;
+	case 7:
+		letter = 0x63; //u
+		break;
+	case ATTR_TEMPO:
+		letter = 0x07; //t
 		break;
 	}
 
@@ -275,579 +383,169 @@ void segsum(uint16_t sum, uint8_t colon, uint8_t attribute, uint8_t channel, uin
 	{
 		display_pattern(displays3[0], displays4[0], dis_lengths[0], 20);
 	}
-}
 
-/***********************************************
- *
- *
- *CONTROL MECHANISMS FOR EXCEEDING OCTAVE/STEP BOUNDRIES with the 8th note
- *
- *
- **********************************************/
-void set_control(uint8_t channel, uint8_t attribute, uint8_t inc)
-{
-	if (channel == 1)
+	//10 and up (root, scale, step length) needs digit1 for the tens, the
+	//indicator moves left of the colon in place of half the pattern. The
+	//hundreds of the tempo push it out over the other half
+	if (sum >= 100)
 	{
-		switch (attribute)
-		{
-		case 1: //steps
-			if (inc)
-			{ //octaves can be 0-8, 0 being the lowest!
-				switch (octave1)
-				{ //if we want to increment the number of steps to be taken we need to check the octave
-				case 0:
-					if (steps1 > 9)
-					{ //we can go a maximum of 9 steps at the 0th octave
-						steps1 = 9;
-					}
-					if (steps1 < 9)
-						steps1++;
-					break;
-				case 1:
-					if (steps1 > 8)
-					{
-						steps1 = 8;
-					}
-					if (steps1 < 8)
-						steps1++;
-					break;
-				case 2:
-					if (steps1 > 7)
-					{
-						steps1 = 7;
-					}
-					if (steps1 < 7)
-						steps1++;
-					break;
-				case 3:
-					if (steps1 > 6)
-					{
-						steps1 = 6;
-					}
-					if (steps1 < 6)
-						steps1++;
-					break;
-				case 4:
-					if (steps1 > 5)
-					{
-						steps1 = 5;
-					}
-					if (steps1 < 5)
-						steps1++;
-					break;
-				case 5:
-					if (steps1 > 4)
-					{
-						steps1 = 4;
-					}
-					if (steps1 < 4)
-						steps1++;
-					break;
-				case 6:
-					if (steps1 > 3)
-					{
-						steps1 = 3;
-					}
-					if (steps1 < 3)
-						steps1++;
-					break;
-				case 7:
-					if (steps1 > 2)
-					{
-						steps1 = 2;
-					}
-					if (steps1 < 2)
-						steps1++;
-					break;
-				case 8:
-					if (steps1 > 1)
-					{
-						steps1 = 1;
-					}
-					if (steps1 < 1)
-						steps1++;
-					break;
-				}
-			}
-			else
-			{ //decrement the number of steps
-				if (steps1 > 1)
-					steps1--;
-			}
-			break;
-		case 2: //rate
-			if (inc)
-			{
-				if (rate1 < 9)
-					rate1++;
-			}
-			else
-			{
-				if (rate1 > 1)
-					rate1--;
-			}
-			break;
-		case 3: //octave
-			if (inc)
-			{
-				switch (steps1)
-				{ //if we want to increment the number of steps to be taken we need to check the octave
-				case 1:
-					if (octave1 > 8)
-					{
-						octave1 = 8;
-					}
-					if (octave1 < 8)
-						octave1++;
-					break;
-				case 2:
-					if (octave1 > 7)
-					{
-						octave1 = 7;
-					}
-					if (octave1 < 7)
-						octave1++;
-					break;
-				case 3:
-					if (octave1 > 6)
-					{
-						octave1 = 6;
-					}
-					if (octave1 < 6)
-						octave1++;
-					break;
-				case 4:
-					if (octave1 > 5)
-					{
-						octave1 = 5;
-					}
-					if (octave1 < 5)
-						octave1++;
-					break;
-				case 5:
-					if (octave1 > 4)
-					{
-						octave1 = 4;
-					}
-					if (octave1 < 4)
-						octave1++;
-					break;
-				case 6:
-					if (octave1 > 3)
-					{
-						octave1 = 3;
-					}
-					if (octave1 < 3)
-						octave1++;
-					break;
-				case 7:
-					if (octave1 > 2)
-					{
-						octave1 = 2;
-					}
-					if (octave1 < 2)
-						octave1++;
-					break;
-				case 8:
-					if (octave1 > 1)
-					{
-						octave1 = 1;
-					}
-					if (octave1 < 1)
-						octave1++;
-					break;
-				case 9:
-					if (octave1 > 0)
-					{
-						octave1 = 0;
-					}
-					if (octave1 < 0)
-						octave1++;
-					break;
-				}
-			}
-			else
-			{
-				if (octave1 > 0)
-					octave1--;
-			}
-			break;
-
-		case 4: //arp type
-			if (inc)
-			{
-				if (type1 < 4)
-				{
-					type1++;
-				}
-			}
-			else
-			{
-				if (type1 > 1)
-				{
-					type1--;
-				}
-			}
-			break;
-		case 5: //mode
-			if (inc)
-			{
-				if (modal1 < 6)
-				{
-					modal1++;
-				}
-			}
-			else
-			{
-				if (modal1 > 0)
-				{
-					modal1--;
-				}
-			}
-			switch (modal1){
-				case 0:
-					mode1 = C; 
-					mode1_d = C_d; 
-					break;
-				case 1:
-					mode1 = dorian; 
-					mode1_d = dorian_d; 
-					break;
-				case 2:
-					mode1 = phrygian; 
-					mode1_d = phrygian_d; 
-					break;
-				case 3:
-					mode1 = lydian; 
-					mode1_d = lydian_d; 
-					break;
-				case 4:
-					mode1 = mixolydian; 
-					mode1_d = mixolydian_d; 
-					break;
-				case 5:
-					mode1 = aeolian; 
-					mode1_d = aeolian_d; 
-					break;
-				case 6:
-					mode1 = locrian; 
-					mode1_d = locrian_d; 
-					break;
-			}
-			break;
-		}
+		segment_data[1] = segment_codes[(sum / 10) % 10];
+		segment_data[3] = segment_codes[(sum / 100) % 10];
+		segment_data[4] = letter;
 	}
-	else if (channel == 2)
+	else if (sum >= 10)
 	{
-		switch (attribute)
-		{
-		case 1: //steps
-			if (inc)
-			{ //octaves can be 0-8, 0 being the lowest!
-				switch (octave2)
-				{ //if we want to increment the number of steps to be taken we need to check the octave
-				case 0:
-					if (steps2 > 9)
-					{ //we can go a maximum of 9 steps at the 0th octave
-						steps2 = 9;
-					}
-					if (steps2 < 9)
-						steps2++;
-					break;
-				case 1:
-					if (steps2 > 8)
-					{
-						steps2 = 8;
-					}
-					if (steps2 < 8)
-						steps2++;
-					break;
-				case 2:
-					if (steps2 > 7)
-					{
-						steps2 = 7;
-					}
-					if (steps2 < 7)
-						steps2++;
-					break;
-				case 3:
-					if (steps2 > 6)
-					{
-						steps2 = 6;
-					}
-					if (steps2 < 6)
-						steps2++;
-					break;
-				case 4:
-					if (steps2 > 5)
-					{
-						steps2 = 5;
-					}
-					if (steps2 < 5)
-						steps2++;
-					break;
-				case 5:
-					if (steps2 > 4)
-					{
-						steps2 = 4;
-					}
-					if (steps2 < 4)
-						steps2++;
-					break;
-				case 6:
-					if (steps2 > 3)
-					{
-						steps2 = 3;
-					}
-					if (steps2 < 3)
-						steps2++;
-					break;
-				case 7:
-					if (steps2 > 2)
-					{
-						steps2 = 2;
-					}
-					if (steps2 < 2)
-						steps2++;
-					break;
-				case 8:
-					if (steps2 > 1)
-					{
-						steps2 = 1;
-					}
-					if (steps2 < 1)
-						steps2++;
-					break;
-				}
-			}
-			else
-			{ //decrement the number of steps
-				if (steps2 > 1)
-					steps2--;
-			}
-			break;
-		case 2: //rate
-			if (inc)
-			{
-				if (rate2 < 9)
-					rate2++;
-			}
-			else
-			{
-				if (rate2 > 1)
-					rate2--;
-			}
-			break;
-		case 3: //octave
-			if (inc)
-			{
-				switch (steps2)
-				{ //if we want to increment the number of steps to be taken we need to check the octave
-				case 1:
-					if (octave2 > 8)
-					{
-						octave2 = 8;
-					}
-					if (octave2 < 8)
-						octave2++;
-					break;
-				case 2:
-					if (octave2 > 7)
-					{
-						octave2 = 7;
-					}
-					if (octave2 < 7)
-						octave2++;
-					break;
-				case 3:
-					if (octave2 > 6)
-					{
-						octave2 = 6;
-					}
-					if (octave2 < 6)
-						octave2++;
-					break;
-				case 4:
-					if (octave2 > 5)
-					{
-						octave2 = 5;
-					}
-					if (octave2 < 5)
-						octave2++;
-					break;
-				case 5:
-					if (octave2 > 4)
-					{
-						octave2 = 4;
-					}
-					if (octave2 < 4)
-						octave2++;
-					break;
-				case 6:
-					if (octave2 > 3)
-					{
-						octave2 = 3;
-					}
-					if (octave2 < 3)
-						octave2++;
-					break;
-				case 7:
-					if (octave2 > 2)
-					{
-						octave2 = 2;
-					}
-					if (octave2 < 2)
-						octave2++;
-					break;
-				case 8:
-					if (octave2 > 1)
-					{
-						octave2 = 1;
-					}
-					if (octave2 < 1)
-						octave2++;
-					break;
-				case 9:
-					if (octave2 > 0)
-					{
-						octave2 = 0;
-					}
-					if (octave2 < 0)
-						octave2++;
-					break;
-				}
-			}
-			else
-			{
-				if (octave2 > 0)
-					octave2--;
-			}
-			break;
-		case 4: //arp type
-			if (inc)
-			{
-				if (type2 < 4)
-					type2++;
-			}
-			else
-			{
-				if (type2 > 1)
-					type2--;
-			}
-			break;
-		case 5: //mode
-			if (inc)
-			{
-				if (modal2 < 6)
-				{
-					modal2++;
-				}
-			}
-			else
-			{
-				if (modal2 > 0)
-				{
-					modal2--;
-				}
-			}
-			switch (modal2){
-				case 0:
-					mode2 = C; 
-					mode2_d = C_d; 
-					break;
-				case 1:
-					mode2 = dorian; 
-					mode2_d = dorian_d; 
-					break;
-				case 2:
-					mode2 = phrygian; 
-					mode2_d = phrygian_d; 
-					break;
-				case 3:
-					mode2 = lydian; 
-					mode2_d = lydian_d; 
-					break;
-				case 4:
-					mode2 = mixolydian; 
-					mode2_d = mixolydian_d; 
-					break;
-				case 5:
-					mode2 = aeolian; 
-					mode2_d = aeolian_d; 
-					break;
-				case 6:
-					mode2 = locrian; 
-					mode2_d = locrian_d; 
-					break;
-			}
-			break;
-		case 6: //rate
-			if (inc)
-			{
-				if (repeat2 < 16)
-					repeat2++;
-			}
-			else
-			{
-				if (repeat2 > 1)
-				{
-					repeat2--;
-					repeat_counter = 0;
-				}
-			}
-			break;
-		}
+		segment_data[1] = segment_codes[(sum / 10) % 10];
+		segment_data[3] = letter;
 	}
+	else
+		segment_data[1] = letter;
+}
+
+/***********************************************************************
+ *Function:		next_attribute()
+ *Description:		Steps the attribute selected by the left encoder
+ *			forwards (inc = 1) or backwards, wrapping around.
+ *			1-steps, 2-rate, 3-octave, 4-type, 5-scale, 0-root and
+ *			8-tempo are on every channel, 6-step length only on
+ *			SEQUENCER_CH and 7-wave only in TONE_DDS builds. The
+ *			tempo is the same for every channel.
+ ***********************************************************************/
+uint8_t next_attribute(uint8_t channel, uint8_t attribute, uint8_t inc)
+{
+	do
+	{
+		if (inc)
+			attribute = attribute < ATTR_TEMPO ? attribute + 1 : 0;
+		else
+			attribute = attribute > 0 ? attribute - 1 : ATTR_TEMPO;
+#ifndef TONE_DDS
+	} while ((attribute == 6 && channel != SEQUENCER_CH) || attribute == 7);
+#else
+	} while (attribute == 6 && channel != SEQUENCER_CH);
+#endif
+	return attribute;
 }
 
+//the blink_LED() LEDs. PE3 is OC3A, channel 2's tone, in TONE_HW builds
+//and the pin follows PORTE bit 3 while a rest disconnects the compare
+//output, so LED 3 stays dark and the bit low there (see music.h). In
+//TONE_DDS builds OC3A is the DAC and is left alone the same way
+#if defined(TONE_HW) || defined(TONE_DDS)
+#define LED_BITS ((1 << PE0) | (1 << PE1) | (1 << PE2))
+#else
+#define LED_BITS ((1 << PE0) | (1 << PE1) | (1 << PE2) | (1 << PE3))
+#endif
+
 void blink_LED(uint8_t counter)
 {
-	switch (counter)
+	//lights LED counter (0-3, PE0-PE3) alone, anything else turns all
+	//four off. Pages can jump, so the other three are always cleared.
+	//Without LED 3 the other three light together in its place
+	uint8_t sreg;
+	uint8_t led = counter < 4 ? 1 << counter : 0;
+
+	if (led & ~LED_BITS)
+		led = LED_BITS;
+
+	//not a single sbi/cbi, the SPI ISR changes PE5/PE6 in between
+	sreg = SREG;
+	cli();
+	PORTE = (PORTE & ~LED_BITS) | led;
+	SREG = sreg;
+}
+
+/***********************************************************************
+ *Function:		record_step()
+ *Description:		Sequence buttons PF0-PF3 on SEQUENCER_CH, step
+ *			recording. Writes the step at the cursor and moves
+ *			the cursor on, the pattern grows to take it:
+ *			0-the keys held (none is a rest), 1-the keys held,
+ *			accented, 2-a tie. 3 ends the pattern at the cursor
+ *			and takes the cursor back to step 0.
+ ***********************************************************************/
+static uint8_t record_pos; //the cursor
+
+static void record_step(uint8_t button, uint8_t keys)
+{
+	switch (button)
 	{
 	case 0:
-		PORTE |= (1 << PE0);
-		PORTE &= ~(1 << PE3);
+		pattern_set(record_pos, keys, PAT_DEFAULT);
 		break;
 	case 1:
-		PORTE |= (1 << PE1);
-		PORTE &= ~(1 << PE0);
+		pattern_set(record_pos, keys, PAT_DEFAULT | PAT_ACCENT);
 		break;
 	case 2:
-		PORTE |= (1 << PE2);
-		PORTE &= ~(1 << PE1);
+		pattern_set(record_pos, 0, PAT_DEFAULT | PAT_TIE);
 		break;
 	case 3:
-		PORTE |= (1 << PE3);
-		PORTE &= ~(1 << PE2);
-		break;
-	case 5:
-		PORTE &= ~((1 << PE0) | (1 << PE1) | (1 << PE2) | (1 << PE3));
+		if (record_pos)
+			pattern_length(record_pos);
+		record_pos = 0;
+		return;
 	}
+	if (record_pos >= pattern_len)
+		pattern_length(record_pos + 1);
+	if (++record_pos >= PATTERN_STEPS)
+		record_pos = 0;
 }
 
-//!!!!1
 /***********************************************************************
- *Function: 		timer0 ISR          
- *Description:        	This functions polls the push buttons,
- *                  	polls the encoders and writes the mode to the bar graph display
- *                 	The function increases the values of the clock or alarm based of the encoder input 
- *                	and also increment ths number of minutes every 60 seconds.
+ *Function: 		timer2 ISR
+ *Description:		Writes the next digit of segment_data to the
+ *			display, one digit per overflow (~195Hz refresh).
+ *			Also samples main_busy for idle_percent.
  ***********************************************************************/
-ISR(TIMER0_OVF_vect)
+ISR(TIMER2_OVF_vect)
 {
-	static uint8_t encoder_val; //value read in from the encoder SPI
-	uint8_t i;
-	static uint8_t tempo = 8;
-	static uint16_t ms;
-	//static uint8_t play_count = 0;
+	static uint16_t samples;
+	static uint16_t busy;
+	ISR_PROFILE_BEGIN();
+
+	//make PORTA an output
+	DDRA = 0xFF;
+
+	//send 7 segment code to LED segments
+	PORTA = segment_data[digit_to_display];
 
-	ms++;
-	if (ms % tempo == 0)
+	//send PORTB the digit to display
+	PORTB = digit_select[digit_to_display];
+
+	if (++digit_to_display >= 5)
+		digit_to_display = 0;
+
+	if (main_busy)
+		busy++;
+	if (++samples == IDLE_WINDOW)
 	{
-		//for note duration (64th notes)
-		beat++;
-		beat2++;
+		idle_percent = 100 - (busy * 25 >> 8); //busy * 100 / IDLE_WINDOW
+		samples = 0;
+		busy = 0;
 	}
+	ISR_PROFILE_END();
+}
+
+/***********************************************************************
+ *Function: 		timer0 ISR          
+ *Description:        	Runs the beat clock and the DDS envelopes, then
+ *			takes a snapshot of the push buttons, keys and
+ *			encoders for input_task() and queues the next encoder
+ *			read. Everything else happens in main.
+ ***********************************************************************/
+ISR(TIMER0_OVF_vect)
+{
+	uint8_t h = input_head;
+	uint8_t next = (h + 1) & (INPUT_SAMPLES - 1);
+	ISR_PROFILE_BEGIN();
+
+#ifdef TONE_DDS
+	//envelopes run at the control rate, not the sample rate
+	synth_control();
+#endif
+
+	//beat clock, ticks music_tick() once per 64th note at the current tempo
+	music_clock();
 
 	//make PORTA an input port with pullups, write all 0's to DDRA and all 1's to PORTA
 	DDRA = 0x00;
@@ -856,143 +554,132 @@ ISR(TIMER0_OVF_vect)
 	//enable tristate buffer for pushbutton switches, write PORTC bits 4-6 all HIGH
 	PORTB = (1 << PB4) | (1 << PB5) | (1 << PB6);
 
-	//now check each button and increment the count as needed
-	for (i = 0; i < 8; i++)
+	//a full buffer drops the sample, main is more than INPUT_SAMPLES ticks behind
+	//PINA is read last to give the tristate buffer and the pin synchronizer time
+	if (next != input_tail)
 	{
-		if (chk_buttons(i))
-		{
-			if (switch_ch == 1)
-				notes_to_play1 |= (1 << i);
-			else
-				notes_to_play2 |= (1 << i);
-		}
-		else if (switch_ch == 1)
-			notes_to_play1 &= ~(1 << i); //!!!1
-		else
-			notes_to_play2 &= ~(1 << i);
+		input_buf[h].pinc = PINC;
+		input_buf[h].pinf = PINF;
+		input_buf[h].encoders = encoder_val;
+		input_buf[h].pina = PINA;
+		input_head = next;
 	}
 
+	//encoder_done() keeps the byte, the next sample takes it
+	spi_transfer(0x00, encoder_load, encoder_done);
+
+	//disable tristate buffer for pushbutton switches, toogle the Y5 output for safety
+	PORTB = (1 << PB4) | (0 << PB5) | (1 << PB6);
+
+	//re-enable the bar graph for brightness
+	PORTD &= ~(1 << PD2);
+	ISR_PROFILE_END();
+}
+
+/***********************************************************************
+ *Function: 		input_task()
+ *Description:        	Cooperative task for the main loop. Processes
+ *			one Timer0 input snapshot: debounces the buttons,
+ *			decodes the encoders, runs save/delete and the
+ *			sequencer, sends the control events and updates
+ *			the 7 segment display. Returns 0 when there was no
+ *			snapshot waiting.
+ ***********************************************************************/
+uint8_t input_task(void)
+{
+	uint8_t i;
+	int8_t step;
+	static uint8_t held[ARP_CHANNELS]; //notes each channel should be playing
+	static uint8_t sent[ARP_CHANNELS]; //notes the last EV_NOTES carried
+	static debounce_t keys_a, buttons_c, buttons_f;
+	static uint8_t page = 0xFF; //lit by blink_LED()
+	arp_channel_t *c = &arp[switch_ch - 1];
+	input_sample_t *in;
+
+	if (input_tail == input_head)
+		return 0;
+	in = &input_buf[input_tail];
+
+	//debounce the note keys and the two button ports, the keys play while held
+	debounce(&keys_a, in->pina);
+	debounce(&buttons_c, in->pinc | ~0x07); //PC0-PC2, PC5-PC7 are the channel LEDs
+	debounce(&buttons_f, in->pinf | ~0x3F); //PF0-PF5
+	held[switch_ch - 1] = keys_a.held;
+
 	//check for state change input, save notes, delete notes, switch channel
 	for (i = 0; i < 3; i++)
 	{
-		if (chk_buttonsC(i))
+		if (buttons_c.press & (1 << i))
 		{
 			if (i == 0 && switch_ch == 1) //save1
 				save1 = 1;
 			if (i == 1)
 				delete1 = 1;
 			if (i == 2)
-			{ //far left button
-				if (switch_ch == 1)
-				{
-					switch_ch = 2;
-					PORTC &= ~((1 << PC7) | (1 << PC6) | (1 << PC5));
-					PORTC |= (1 << PC6) | (1 << PC5);
-				}
-				else if (switch_ch == 2)
-				{
-					switch_ch = 1;
-					PORTC &= ~((1 << PC7) | (1 << PC6) | (1 << PC5));
-					PORTC |= (1 << PC7) | (1 << PC5);
-				}
+			{ //far left button, step through the channels
+				switch_ch = (switch_ch >= ARP_CHANNELS) ? 1 : switch_ch + 1;
+				c = &arp[switch_ch - 1];
+				PORTC &= ~((1 << PC7) | (1 << PC6) | (1 << PC5));
+				PORTC |= channel_leds[switch_ch - 1];
 			}
 		}
 	}
 
-	//check for channel 2 configurations
+	//check the pattern sequencer buttons
 	for (i = 0; i < 6; i++)
 	{
-		if (chk_buttonsF(i))
+		if (buttons_f.press & (1 << i))
 		{
-			if (i == 0 && switch_ch == 2)
-				sequence_to_play[0] = notes_to_play2;
-			if (i == 1 && switch_ch == 2)
-				sequence_to_play[1] = notes_to_play2;
-			if (i == 2 && switch_ch == 2)
-				sequence_to_play[2] = notes_to_play2;
-			if (i == 3 && switch_ch == 2)
-				sequence_to_play[3] = notes_to_play2;
+			if (i < 4 && switch_ch == SEQUENCER_CH)
+				record_step(i, held[SEQUENCER_CH - 1]);
 			if (i == 4)
 			{
-				play = 1;
+				pattern_start();
 				PORTE |= (1 << PE4); //sequence playing LED
-				sequence_flag = 0;
+				event_push(EV_SYNC, 0); //line the channels up with the pattern
 			}
 			if (i == 5)
 			{
-				stop = 1;
+				pattern_stop();
 				PORTE &= ~(1 << PE4);
 			}
 		}
 	}
 
-	//now check the encoders for input
-	//Connections:
-	//	CLK_INH:	PORTE, bit 6
-	//	SHIFT_LD_N: 	PORTE, bit 5
-	PORTE |= (1 << PE6); //parallel load the 74HC165, write a 1 to CLK_INH and a 0 to SHIFT_LD_N
-	PORTE &= ~(1 << PE5);
-	PORTE &= ~(1 << PE6);
-	PORTE |= (1 << PE5);	  //enable shift mode reactivate CLK, CLK_ING = 0 and SHIFT_LD_N = 1
-	encoder_val = spi_read(); //read the data
-	PORTE |= (1 << PE6);	  //disable this slave device so we can write to bar graph
-
-	//check the left encoder CONTROL ATTRIBUTE: 1-steps, 2-rate, 3-octave, if in channel 2 repeat
-	if (((prev & 0b11) == 0b11) && ((encoder_val & 0b11) == 0b10))
-	{ //we have clockwise rotation of the encoders, we see a shift from 0b11 to 0b10
-		if (switch_ch == 1)
-		{
-			attribute1++;
-			if (attribute1 > 5)
-				attribute1 = 1;
-		}
-		if (switch_ch == 2)
-		{
-			attribute2++;
-			if (attribute2 > 6)
-				attribute2 = 1;
-		}
-	}
-	else if (((prev & 0b11) == 0b11) && ((encoder_val & 0b11) == 0b01))
-	{ //we have counter clockwise rotation
-		if (switch_ch == 1)
-		{
-			attribute1--;
-			if (attribute1 < 1)
-				attribute1 = 5;
-		}
-		if (switch_ch == 2)
-		{
-			attribute2--;
-			if (attribute2 < 1)
-				attribute2 = 6;
-		}
-	}
-
-	//check the right encoder
-	if (((prev & 0b1100) == 0b1100) && ((encoder_val & 0b1100) == 0b1000))
-	{
-		if (switch_ch == 1)
-			set_control(1, attribute1, 1);
-		if (switch_ch == 2)
-			set_control(2, attribute2, 1);
-	}
-	else if (((prev & 0b1100) == 0b1100) && ((encoder_val & 0b1100) == 0b0100))
+	//the page the pattern is playing, or the one being recorded into
+	if (pattern_running)
+		i = pattern_pos / PATTERN_PAGE;
+	else if (switch_ch == SEQUENCER_CH)
+		i = record_pos / PATTERN_PAGE;
+	else
+		i = 5; //all off
+	if (i != page)
 	{
-		if (switch_ch == 1)
-			set_control(1, attribute1, 0);
-		if (switch_ch == 2)
-			set_control(2, attribute2, 0);
+		blink_LED(i);
+		page = i;
 	}
 
-	//disable tristate buffer for pushbutton switches, toogle the Y5 output for safety
-	PORTB = (1 << PB4) | (0 << PB5) | (1 << PB6);
-
-	//re-enable the bar graph for brightness
-	PORTD &= ~(1 << PD2);
-
-	//set prev equal to the current state
-	prev = encoder_val;
+	//check the left encoder CONTROL ATTRIBUTE: 1-steps, 2-rate, 3-octave, if in channel 2 step length
+	//one attribute per detent however fast it turns
+	step = encoder_read(&enc_left, in->encoders & 0b11);
+	if (step > 0)
+		c->attribute = next_attribute(switch_ch, c->attribute, 1);
+	else if (step < 0)
+		c->attribute = next_attribute(switch_ch, c->attribute, 0);
+
+	//check the right encoder, fast turns move the value further
+	step = encoder_read(&enc_right, (in->encoders >> 2) & 0b11);
+	if (c->attribute == ATTR_TEMPO)
+	{ //a BPM a step, 4 a detent turned fast
+		if (step > 0)
+			event_push(EV_TEMPO, EV_STEPS(step) | EV_UP);
+		else if (step < 0)
+			event_push(EV_TEMPO, EV_STEPS(-step));
+	}
+	else if (step > 0)
+		event_push(EV_PARAM | (switch_ch - 1), c->attribute | EV_STEPS(step) | EV_UP);
+	else if (step < 0)
+		event_push(EV_PARAM | (switch_ch - 1), c->attribute | EV_STEPS(-step));
 
 	//save notes
 	static uint8_t saved_notes1 = 0;
@@ -1000,118 +687,110 @@ ISR(TIMER0_OVF_vect)
 	//check for channel
 	if (save1)
 	{
-		saved_notes1 = notes_to_play1; //save the notes
+		saved_notes1 = held[0]; //save the notes
 		saved1_flag = 1;
 		save1 = 0;
 	}
 	if (saved1_flag == 1)
-		notes_to_play1 = saved_notes1;
+		held[0] = saved_notes1;
 	if (delete1 == 1)
 	{
 		saved1_flag = 0;
 		delete1 = 0;
-		notes_to_play1 = 0;
+		held[0] = 0;
 	}
 
-	static uint8_t counter = 0;
-
-	if (play)
-	{
-		if (sequence_flag)
-		{
-			/*if(rate2 == 1 && counter == 3 && (sequence_to_play[counter] == 1 || sequence_to_play[counter] == 2 || sequence_to_play[counter] == 4 || sequence_to_play[counter] == 8 || sequence_to_play[counter] == 16 ||
-			   sequence_to_play[counter] == 32 || sequence_to_play[counter] == 64 || sequence_to_play[counter] == 128 || sequence_to_play[counter] == 256)){
-					repeat_counter += 4; 
-			} 
-			else{*/
-
-			repeat_counter++;
-
-			if (repeat_counter == repeat2)
-			{
-				repeat_counter = 0;
-				counter++;
-				counter %= 4;
-				blink_LED(counter);
-			}
-			sequence_flag = 0;
-		}
-		notes_to_play2 = sequence_to_play[counter];
-	}
-	if (stop)
+	//hand the note changes to music_update(), a full queue is retried next sample
+	for (i = 0; i < ARP_CHANNELS; i++)
 	{
-		counter = 0;
-		blink_LED(5); //turn all LEDS off
-		play = 0;
-		stop = 0;
-		notes_to_play2 = 0;
+		if (held[i] != sent[i] && event_push(EV_NOTES | i, held[i]))
+			sent[i] = held[i];
 	}
 
 	//set value to be displayed to the LED
-	if (switch_ch == 1)
+	switch (c->attribute)
 	{
-		switch (attribute1)
-		{
-		case 1:
-			count = steps1;
-			break;
-		case 2:
-			count = rate1;
-			break;
-		case 3:
-			count = octave1;
-			break;
-		case 4:
-			count = type1;
-			break;
-		case 5:
-			count = modal1;
-			break;
-		}
-	}
-	else
-	{
-		switch (attribute2)
-		{
-		case 1:
-			count = steps2;
-			break;
-		case 2:
-			count = rate2;
-			break;
-		case 3:
-			count = octave2;
-			break;
-		case 4:
-			count = type2;
-			break;
-		case 5:
-			count = modal2;
-			break;
-		case 6:
-			count = repeat2;
-			break;
-		}
+	case 1:
+		count = c->steps;
+		break;
+	case 2:
+		count = c->rate;
+		break;
+	case 3:
+		count = c->octave;
+		break;
+	case 4:
+		count = c->type;
+		break;
+	case 0:
+		count = c->root;
+		break;
+	case 5:
+		count = c->scale;
+		break;
+	case 6:
+		count = c->step_len;
+		break;
+	case 7:
+		count = c->wave;
+		break;
+	case ATTR_TEMPO:
+		count = tempo / 10;
+		break;
 	}
 
 	//call segsum
-	if (switch_ch == 1)
-		segsum(count, 0xff, attribute1, 1, notes_to_play1); //value, colon, attribute, channel, 0xfc to turn on colon
-	else
-		segsum(count, 0xff, attribute2, 1, notes_to_play2);
+	segsum(count, 0xff, c->attribute, 1, held[switch_ch - 1]); //value, colon, attribute, channel, 0xfc to turn on colon
+
+	input_tail = (input_tail + 1) & (INPUT_SAMPLES - 1);
+	return 1;
 }
 
+#ifdef BENCH
 /***********************************************************************
-	 *Function:       	set_volume()      
-	 *Description:         	This function is called within main. Based off of the 
-	 *                    	the value in the passed paramter, the value of OCR3A 
-	 *                   	will change accordingly to detemine the volume of the 
-	 *                  	audio amplifier output.
-	 *			NOTE: timer 3 is configured in inverting mode, 
-	 *			the smaller the value of OCR3A, the louder the amplifier!
-	 ***********************************************************************/
-int main()
+ *Function:		bench_load()
+ *Description:		Applies the avr_bench.c preset in the EEPROM to
+ *			every channel and starts its pattern, see
+ *			bench.h. arp_init() runs in main, the controls'
+ *			only writer, so no events.
+ ***********************************************************************/
+static void bench_load(void)
 {
+	bench_preset_t p;
+	uint8_t i;
+
+	eeprom_read_block(&p, (const void *)0, sizeof(p));
+	if (p.magic != BENCH_MAGIC)
+		return;
+	for (i = 0; i < ARP_CHANNELS; i++)
+	{
+		arp[i].type = p.type;
+		arp[i].steps = p.steps;
+		arp[i].octave = p.octave;
+		arp[i].notes_to_play = p.notes;
+	}
+	if (!p.pattern)
+		return;
+	//step_len 1 so a step starts every 4 beats, every gate length, the
+	//octaves either side, an accent and a tie in each 8 steps
+	for (i = 0; i < PATTERN_STEPS; i++)
+		pattern_set(i, p.notes, PAT_FLAGS((i & 7) + 1, (i & 3) - 1) |
+			((i & 7) == 3 ? PAT_ACCENT : 0) | ((i & 7) == 6 ? PAT_TIE : 0));
+	pattern_length(p.pattern);
+	pattern_start();
+}
+#endif
+
+/***********************************************************************
+ *Function:		arp_init()
+ *Description:		Sets up the ports, timers, SPI and the channels,
+ *			then enables interrupts. main() calls it once
+ *			before running arp_loop() forever.
+ ***********************************************************************/
+void arp_init(void)
+{
+	uint8_t i;
+
 	//set port bits 4-7 B as outputs, a 1 in DDRB.n indicates that pin n of the given port is an output
 	DDRB = 0xFF;
 
@@ -1134,6 +813,11 @@ int main()
 	//Disable the tristate buffer, write unconnected pin Y5 LOW
 	PORTB = (1 << PB4) | (0 << PB5) | (1 << PB6);
 
+	//no snapshots or recording from before, a host build runs this again
+	input_head = 0;
+	input_tail = 0;
+	record_pos = 0;
+
 	//initialize SPI, and timers
 	tcnt0_init();
 	tcnt2_init();
@@ -1143,47 +827,22 @@ int main()
 	//enable interrupts
 	sei();
 
-	//read the initial state of encoders
-	PORTE |= (1 << PE6);
-	PORTE |= (1 << PE5);
-	prev = spi_read();
-
 	//initialize global variables
 	digit_to_display = 0;
 
-	//Channel1 initializers
-	type1 = 1;
-	rate1 = 1;
-	steps1 = 2;
-	octave1 = 2;
-	attribute1 = 1;
-	count = rate1;
-
-	modal1 = 0;
-	mode1 = C;
-	mode1_d = C_d;
-
-	//Initialize the up down, donw up pattern behavior
-	p_flag1 = 1;
-	p_flag2 = 1;
-
-	//channel 2 initializers
-	type2 = 1;
-	rate2 = 1;
-	steps2 = 2;
-	octave2 = 2;
-	attribute2 = 1;
-	repeat2 = 1;
-	repeat_counter = 0;
-
-	modal2 = 0;
-	mode2 = C;
-	mode2_d = C_d;
-
-	//sequence constants
-	sequence_flag = 0;
-	play = 0;
-	stop = 0;
+	//channel initializers
+	for (i = 0; i < ARP_CHANNELS; i++)
+	{
+		arp[i].type = 1;
+		arp[i].rate = 1;
+		arp[i].steps = 2;
+		arp[i].octave = 2;
+		arp[i].attribute = 1;
+		arp[i].scale = 0;
+		arp[i].root = 0;
+		arp[i].step_len = 1;
+	}
+	count = arp[0].rate;
 
 	//start on channel 1
 	switch_ch = 1;
@@ -1191,25 +850,41 @@ int main()
 	//set the 7 segment brightness
 	OCR2 = 255;
 
-	while (1)
-	{
-		//bound a counter (0-4) to keep track of the digit to display (so on each iteration of the llop we only target on digit)
-		digit_to_display = digit_to_display % 5;
-
-		//make PORTA an output
-		DDRA = 0xFF;
-
-		//send 7 segment code to LED segments on each iteration we only update a single digit
-		PORTA = segment_data[digit_to_display];
-
-		//send PORTB the digit to display
-		PORTB = digit_select[digit_to_display];
+#ifdef BENCH
+	bench_load();
+#endif
+}
 
-		//delay to ensure the segment reachs full brightness
-		_delay_ms(1);
+/***********************************************************************
+ *Function:		arp_loop()
+ *Description:		One pass of the main loop, the background tasks.
+ *			The display is scanned from the Timer2 ISR.
+ ***********************************************************************/
+void arp_loop(void)
+{
+	//buttons, encoders, sequencer and display for each Timer0 snapshot
+	if (input_tail != input_head)
+	{
+		main_busy = 1;
+		while (input_task())
+			;
+		main_busy = 0;
+	}
 
-		//update digit to display
-		digit_to_display++;
+	//recompile the arpeggio step buffers if any of their inputs changed
+	if (music_pending())
+	{
+		main_busy = 1;
+		music_update();
+		main_busy = 0;
+	}
+}
 
-	} //while
+#ifndef HAL_HOST
+int main()
+{
+	arp_init();
+	while (1)
+		arp_loop();
 } //main
+#endif
@@ -0,0 +1,4 @@
+//firmware entry points, main() runs arp_init() once then arp_loop() forever.
+//The HAL_HOST build has no main() here, the host program drives them.
+void arp_init(void);
+void arp_loop(void);
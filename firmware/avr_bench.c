@@ -0,0 +1,281 @@
+/*********************************************************************/
+/*                   ISR cycle benchmark under simavr                */
+/* Runs the -DBENCH firmware image (make bench) in simavr once per   */
+/* preset of the matrix below and times every ISR in CPU cycles, from*/
+/* the vector being taken to its reti, so the register save/restore  */
+/* is counted too. The keys, buttons and encoders read as idle, so   */
+/* only the preset plays.                                            */
+/*                                                                   */
+/*  avr_bench [-s seconds] [-w seconds] [-j] firmware.elf            */
+/*    -s  simulated time per preset, default 2                       */
+/*    -w  warm up before measuring (debounce, first compile), 0.25   */
+/*    -j  JSON instead of CSV                                        */
+/*                                                                   */
+/* Matrix: type 1-4 x steps 1-9 x octave 0/2/4/6/8 (octave + steps   */
+/* at most 9, as set_control() allows) x notes 0x01/0x55/0xFF x no   */
+/* pattern or a 32 step one.                                         */
+/* CSV, one row per preset and ISR:                                  */
+/* type,steps,octave,notes,pattern,isr,count,min,mean,max,p99,cpu_pct*/
+/* cpu_pct is the share of the cycles spent in any ISR, the same on  */
+/* every row of a preset.                                            */
+/*********************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "sim_avr.h"
+#include "sim_elf.h"
+#include "sim_irq.h"
+#include "sim_interrupts.h"
+#include "sim_io.h"
+#include "avr_eeprom.h"
+#include "avr_ioport.h"
+#include "avr_spi.h"
+#include "bench.h"
+#include "pattern.h"
+
+#ifndef F_CPU
+#define F_CPU 16000000UL
+#endif
+
+//an ISR being timed
+typedef struct
+{
+   const char *name;
+   uint8_t vector;
+   avr_cycle_count_t start; //cycle the running ISR was taken on
+   uint32_t *t;             //run times
+   uint32_t n, size;
+} bench_isr_t;
+
+//ATmega128 vector numbers
+static bench_isr_t isr[] = {
+   {"TIMER0_OVF_vect", 16},
+   {"TIMER1_COMPA_vect", 12},
+   {"TIMER3_COMPA_vect", 26},
+   {"TIMER2_OVF_vect", 10},
+};
+#define BENCH_ISRS (sizeof(isr) / sizeof(isr[0]))
+
+static avr_t *avr;
+static avr_cycle_count_t measure_from;
+
+//RUNNING goes to 1 when the vector is taken and back to 0 on its reti
+static void isr_running(struct avr_irq_t *irq, uint32_t value, void *param)
+{
+   bench_isr_t *s = param;
+
+   if (value)
+   {
+      s->start = avr->cycle;
+      return;
+   }
+   if (s->start < measure_from)
+      return;
+   if (s->n == s->size)
+   {
+      s->size = s->size ? s->size * 2 : 1024;
+      s->t = realloc(s->t, s->size * sizeof(*s->t));
+      if (!s->t)
+      {
+         perror("avr_bench");
+         exit(1);
+      }
+   }
+   s->t[s->n++] = (uint32_t)(avr->cycle - s->start);
+}
+
+//the 74HC165 with both encoders resting, the byte every SPI transfer
+//clocks back in (hal_spi_in on the host)
+static void spi_reply(struct avr_irq_t *irq, uint32_t value, void *param)
+{
+   avr_raise_irq(param, 0xFF);
+}
+
+//nothing drives the inputs under simavr and an undriven pin reads low,
+//every key and button held: the keys would send EV_NOTES over the preset
+//and PF4/PF5 start and stop the pattern. The board's pull-ups keep them
+//high with nothing pressed, so do the same here
+static void inputs_idle(void)
+{
+   static const char ports[] = {'A', 'C', 'F'}; //keys, buttons, sequencer
+   uint8_t i, bit;
+
+   for (i = 0; i < sizeof(ports); i++)
+      for (bit = 0; bit < 8; bit++)
+         avr_raise_irq(avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ(ports[i]), bit), 1);
+   avr_irq_register_notify(avr_io_getirq(avr, AVR_IOCTL_SPI_GETIRQ('0'), SPI_IRQ_OUTPUT), spi_reply,
+                           avr_io_getirq(avr, AVR_IOCTL_SPI_GETIRQ('0'), SPI_IRQ_INPUT));
+}
+
+static int cmp_u32(const void *a, const void *b)
+{
+   uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+
+   return x < y ? -1 : x > y;
+}
+
+//runs one preset, leaves the run times in isr[]
+static int bench_run(elf_firmware_t *fw, const bench_preset_t *p, double seconds, double warmup)
+{
+   avr_eeprom_desc_t ee;
+   avr_cycle_count_t end;
+   uint8_t i, v;
+   int state;
+
+   avr = avr_make_mcu_by_name(fw->mmcu);
+   if (!avr)
+   {
+      fprintf(stderr, "avr_bench: unknown MCU %s\n", fw->mmcu);
+      return -1;
+   }
+   avr_init(avr);
+   avr->frequency = F_CPU;
+   avr_load_firmware(avr, fw);
+
+   ee.ee = (uint8_t *)p;
+   ee.offset = 0;
+   ee.size = sizeof(*p);
+   avr_ioctl(avr, AVR_IOCTL_EEPROM_SET, &ee);
+   inputs_idle();
+
+   for (i = 0; i < BENCH_ISRS; i++)
+   {
+      isr[i].n = 0;
+      for (v = 0; v < avr->interrupts.vector_count; v++)
+         if (avr->interrupts.vector[v]->vector == isr[i].vector)
+            avr_irq_register_notify(avr->interrupts.vector[v]->irq + AVR_INT_IRQ_RUNNING, isr_running, &isr[i]);
+   }
+
+   measure_from = (avr_cycle_count_t)(warmup * F_CPU);
+   end = measure_from + (avr_cycle_count_t)(seconds * F_CPU);
+   while (avr->cycle < end)
+   {
+      state = avr_run(avr);
+      if (state == cpu_Done || state == cpu_Crashed)
+      {
+         fprintf(stderr, "avr_bench: firmware stopped at cycle %llu\n", (unsigned long long)avr->cycle);
+         avr_terminate(avr);
+         return -1;
+      }
+   }
+   avr_terminate(avr);
+   return 0;
+}
+
+static void report(const bench_preset_t *p, double seconds, uint8_t json, uint8_t first)
+{
+   uint64_t sum, total = 0;
+   uint32_t min, max, p99, k;
+   double cpu;
+   uint8_t i;
+
+   for (i = 0; i < BENCH_ISRS; i++)
+      for (k = 0; k < isr[i].n; k++)
+         total += isr[i].t[k];
+   cpu = 100.0 * total / (seconds * F_CPU);
+
+   if (json)
+      printf("%s  {\"type\": %u, \"steps\": %u, \"octave\": %u, \"notes\": %u, \"pattern\": %u, \"cpu_pct\": %.3f, "
+             "\"isr\": {", first ? "" : ",\n", p->type, p->steps, p->octave, p->notes, p->pattern, cpu);
+   for (i = 0; i < BENCH_ISRS; i++)
+   {
+      bench_isr_t *s = &isr[i];
+
+      min = max = p99 = 0;
+      sum = 0;
+      if (s->n)
+      {
+         qsort(s->t, s->n, sizeof(*s->t), cmp_u32);
+         min = s->t[0];
+         max = s->t[s->n - 1];
+         p99 = s->t[(s->n * 99 + 99) / 100 - 1];
+         for (k = 0; k < s->n; k++)
+            sum += s->t[k];
+      }
+      if (json)
+         printf("%s\n    \"%s\": {\"count\": %u, \"min\": %u, \"mean\": %.1f, \"max\": %u, \"p99\": %u}",
+                i ? "," : "", s->name, s->n, min, s->n ? (double)sum / s->n : 0.0, max, p99);
+      else
+         printf("%u,%u,%u,0x%02X,%u,%s,%u,%u,%.1f,%u,%u,%.3f\n", p->type, p->steps, p->octave, p->notes,
+                p->pattern, s->name, s->n, min, s->n ? (double)sum / s->n : 0.0, max, p99, cpu);
+   }
+   if (json)
+      printf("}}");
+}
+
+int main(int argc, char **argv)
+{
+   static const uint8_t octaves[] = {0, 2, 4, 6, 8};
+   static const uint8_t masks[] = {0x01, 0x55, 0xFF};
+   static const uint8_t patterns[] = {0, PATTERN_STEPS};
+   double seconds = 2.0, warmup = 0.25;
+   uint8_t json = 0, first = 1;
+   elf_firmware_t fw;
+   bench_preset_t p;
+   unsigned o, m, n;
+   int opt;
+
+   while ((opt = getopt(argc, argv, "s:w:j")) != -1)
+   {
+      switch (opt)
+      {
+      case 's':
+         seconds = atof(optarg);
+         break;
+      case 'w':
+         warmup = atof(optarg);
+         break;
+      case 'j':
+         json = 1;
+         break;
+      default:
+         optind = argc;
+         break;
+      }
+   }
+   if (optind != argc - 1 || seconds <= 0 || warmup < 0)
+   {
+      fprintf(stderr, "usage: %s [-s seconds] [-w seconds] [-j] firmware.elf\n", argv[0]);
+      return 1;
+   }
+
+   memset(&fw, 0, sizeof(fw));
+   if (elf_read_firmware(argv[optind], &fw))
+   {
+      fprintf(stderr, "avr_bench: cannot load %s\n", argv[optind]);
+      return 1;
+   }
+   if (!fw.mmcu[0])
+      strcpy(fw.mmcu, "atmega128");
+
+   if (json)
+      printf("[\n");
+   else
+      printf("type,steps,octave,notes,pattern,isr,count,min,mean,max,p99,cpu_pct\n");
+
+   p.magic = BENCH_MAGIC;
+   for (p.type = 1; p.type <= 4; p.type++)
+      for (p.steps = 1; p.steps <= 9; p.steps++)
+         for (o = 0; o < sizeof(octaves); o++)
+         {
+            p.octave = octaves[o];
+            if (p.octave + p.steps > 9)
+               continue;
+            for (m = 0; m < sizeof(masks); m++)
+               for (n = 0; n < sizeof(patterns); n++)
+               {
+                  p.notes = masks[m];
+                  p.pattern = patterns[n];
+                  if (bench_run(&fw, &p, seconds, warmup))
+                     return 1;
+                  report(&p, seconds, json, first);
+                  first = 0;
+                  fflush(stdout);
+               }
+         }
+
+   if (json)
+      printf("\n]\n");
+   return 0;
+}
@@ -0,0 +1,18 @@
+//Benchmark preset
+//Building with -DBENCH (make bench does) makes arp_init() load the
+//controls of every channel from this block at the start of the EEPROM,
+//so avr_bench.c can run one firmware image under simavr across a matrix
+//of arpeggios without working the encoders, and start a pattern (pattern.h)
+//on SEQUENCER_CH so the step clock is in the Timer0 numbers. Nothing else
+//changes, the ISRs being measured are the ones that ship.
+#define BENCH_MAGIC 0xA5
+
+typedef struct
+{
+   uint8_t magic; //BENCH_MAGIC, otherwise the EEPROM is blank and ignored
+   uint8_t type;
+   uint8_t steps;
+   uint8_t octave;
+   uint8_t notes; //notes_to_play, as if the keys were held
+   uint8_t pattern; //steps of a pattern of notes, 0 for none
+} bench_preset_t;
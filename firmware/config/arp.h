@@ -0,0 +1,9 @@
+//Build variants
+//make VARIANT=<name> forces config/<name>.h into every compile, target and
+//host alike, so one source tree builds all of them (see the Makefile). A
+//variant only defines the build options the headers document, anything it
+//leaves out keeps its default.
+//
+//arp: the two square wave channels toggled from the Timer1/Timer3 compare
+//ISRs on PORTD pins 7 and 6 (music.h)
+#define ARP_CHANNELS 2
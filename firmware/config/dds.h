@@ -0,0 +1,5 @@
+//dds: two channels on the polyphonic DDS engine, Timer3 PWM output
+//(synth.h)
+#define TONE_DDS
+#define DDS_VOICES 4
+#define ARP_CHANNELS 2
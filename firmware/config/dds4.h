@@ -0,0 +1,4 @@
+//dds4: four arpeggiator channels, one DDS voice each (synth.h)
+#define TONE_DDS
+#define DDS_VOICES 4
+#define ARP_CHANNELS 4
@@ -0,0 +1,5 @@
+//hw: two square wave channels toggled by the timer hardware on OC1C and
+//OC3A, no compare ISRs (music.h). The speaker feeds move from PD7/PD6 to
+//PB7 and PE3
+#define TONE_HW
+#define ARP_CHANNELS 2
@@ -0,0 +1,3 @@
+//profile: arp with the longest ISR run time kept in isr_max (profile.h)
+#define ISR_PROFILE
+#define ARP_CHANNELS 2
@@ -0,0 +1,57 @@
+/*********************************************************************/
+/*                   Control event queue for ATMEGA128               */
+/* Single producer, single consumer ring of two byte events. The     */
+/* producer is input_task(), working through the input snapshots the */
+/* Timer0 ISR takes, the consumer music_update(), both in the main   */
+/* loop. See event.h for the split and the event kinds.              */
+/*********************************************************************/
+#include "hal.h"
+#include "event.h"
+
+//one slot is always left empty so head == tail means empty
+static volatile event_t queue[EVENT_QUEUE_LEN];
+static volatile uint8_t head; //next slot to write, producer only
+static volatile uint8_t tail; //next slot to read, consumer only
+
+/*********************************************************************/
+/*                             event_push                            */
+/*Queues an event, returns 0 if the queue is full and it was dropped.*/
+/*Only call from the producer side.                                  */
+/*********************************************************************/
+
+uint8_t event_push(uint8_t code, uint8_t value)
+{
+   uint8_t h = head;
+   uint8_t next = (h + 1) & (EVENT_QUEUE_LEN - 1);
+
+   if (next == tail)
+      return 0;
+   queue[h].code = code;
+   queue[h].value = value;
+   head = next; //publish only once the slot is written
+   return 1;
+}
+
+/*********************************************************************/
+/*                             event_pop                             */
+/*Takes the oldest event off the queue, returns 0 if it was empty.   */
+/*Only call from the consumer side.                                  */
+/*********************************************************************/
+
+uint8_t event_pop(event_t *ev)
+{
+   uint8_t t = tail;
+
+   if (t == head)
+      return 0;
+   ev->code = queue[t].code;
+   ev->value = queue[t].value;
+   tail = (t + 1) & (EVENT_QUEUE_LEN - 1); //hand the slot back only once it is read
+   return 1;
+}
+
+//nonzero while there are events waiting, for the consumer
+uint8_t event_pending(void)
+{
+   return tail != head;
+}
@@ -0,0 +1,55 @@
+//Control events
+//input_task() is the only producer: it turns key, button and encoder input
+//into events instead of writing the arp[] controls directly. music_update()
+//is the only consumer: it drains the queue, applies the events to arp[] and
+//recompiles the step buffers, so the tone side only ever sees a control
+//change at its next step boundary.
+//
+//Both ends run in the main loop, one after the other, so nothing can
+//interrupt a push or a pop. With one writer for head and one for tail, and
+//both indexes a single byte, the ring would still need no cli()/sei() if
+//the producer moved back into an ISR. The cli() in music_update() guards
+//the step buffers the tone side reads, not the queue.
+
+//queue length, a power of two so the indexes wrap with a mask
+#ifndef EVENT_QUEUE_LEN
+#define EVENT_QUEUE_LEN 16
+#endif
+#if EVENT_QUEUE_LEN & (EVENT_QUEUE_LEN - 1)
+#error "EVENT_QUEUE_LEN must be a power of two"
+#endif
+
+//event kinds, the high nibble of code. The low nibble is the channel
+//(0 based) the event is for
+#define EV_NOTES 0x10 //value is the new notes_to_play
+#define EV_PARAM 0x20 //value is attribute | EV_STEPS(n) | EV_UP
+#define EV_SYNC 0x30  //transport, start every channel's arpeggio over
+#define EV_SET 0x40   //value is EV_SET_VALUE(attribute, n), a control set outright
+#define EV_TEMPO 0x50 //value is EV_STEPS(n) | EV_UP in whole BPM, for every channel
+#define EV_KIND 0xF0
+#define EV_CHANNEL 0x0F
+
+//EV_PARAM and EV_TEMPO value fields
+#define EV_ATTRIBUTE 0x07                   //attribute, 0-7 (0 the root)
+#define EV_STEPS(n) ((uint8_t)((n) - 1) << 3) //how many steps to move it, 1-16
+#define EV_STEPS_OF(v) ((((v) >> 3) & 0x0F) + 1)
+#define EV_UP 0x80                          //direction, set to step it up
+
+//the panel attribute past EV_ATTRIBUTE, its steps go out as EV_TEMPO
+#define ATTR_TEMPO 8
+
+//EV_SET value fields, for scripted input (arp_render.c) that knows the
+//value it wants rather than how far to turn
+#define EV_SET_VALUE(attribute, n) ((uint8_t)((attribute) << 5) | ((n) & 0x1F))
+#define EV_SET_ATTRIBUTE(v) ((v) >> 5)
+#define EV_SET_N(v) ((v) & 0x1F)
+
+typedef struct
+{
+   uint8_t code;  //kind | channel
+   uint8_t value;
+} event_t;
+
+uint8_t event_push(uint8_t code, uint8_t value);
+uint8_t event_pop(event_t *ev);
+uint8_t event_pending(void);
@@ -0,0 +1,20 @@
+//Hardware abstraction
+//The firmware only reaches the hardware through the AVR register names,
+//ISR(), cli()/sei()/SREG and the PROGMEM accessors. On the target all of
+//that comes straight from avr-libc and costs nothing. Building with
+//-DHAL_HOST swaps in hal_host.h instead, where the registers are plain
+//variables, the ISRs plain functions and hal_host.c runs them from a
+//simulated clock, so the same sources build into a native program
+//(make host, built for the same config/ variant).
+#ifdef HAL_HOST
+#include "hal_host.h"
+#else
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/pgmspace.h>
+//smaller parts such as the ATmega48 lack PORTA, PORTF, Timer3 and the RAM
+//for the step buffers
+#ifndef __AVR_ATmega128__
+#error "the arpeggiator needs an ATmega128"
+#endif
+#endif
@@ -0,0 +1,249 @@
+/*********************************************************************/
+/*                   Host simulator for the HAL_HOST build           */
+/* Owns the register variables of hal_host.h and raises the firmware */
+/* ISRs from a simulated 16MHz clock: Timer0 (128Hz async), Timer2   */
+/* overflow and the Timer1/Timer3 CTC compares. SPI bytes shift in   */
+/* at once. Output registers can be traced as they change.           */
+/*********************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include "hal.h"
+
+#define HAL_NEVER UINT64_MAX
+
+volatile uint8_t PORTA, PORTB, PORTC, PORTD, PORTE, PORTF;
+volatile uint8_t DDRA, DDRB, DDRC, DDRD, DDRE, DDRF;
+volatile uint8_t PINA = 0xFF, PINB = 0xFF, PINC = 0xFF, PIND = 0xFF, PINE = 0xFF, PINF = 0xFF;
+volatile uint8_t SREG, ASSR, TIMSK, ETIMSK;
+volatile uint8_t TCCR0, TCNT0, TCCR2, TCNT2, OCR2;
+volatile uint8_t TCCR1A, TCCR1B, TCCR1C;
+volatile uint16_t TCNT1, OCR1A, OCR1C;
+volatile uint8_t TCCR3A, TCCR3B, TCCR3C;
+volatile uint16_t TCNT3, OCR3A;
+volatile uint8_t SPCR, SPSR, SPDR;
+
+uint64_t hal_cycles;
+uint8_t hal_spi_in = 0xFF;
+
+//not every build has every vector
+void TIMER1_COMPA_vect(void) __attribute__((weak));
+void TIMER3_COMPA_vect(void) __attribute__((weak));
+
+//registers hal_trace() can watch
+typedef struct
+{
+   const char *name;
+   volatile void *reg;
+   uint8_t size;
+   uint16_t last;
+   uint8_t on;
+} hal_watch_t;
+
+static hal_watch_t watch[] = {
+   {"PORTA", &PORTA, 1}, {"PORTB", &PORTB, 1}, {"PORTC", &PORTC, 1},
+   {"PORTD", &PORTD, 1}, {"PORTE", &PORTE, 1}, {"OCR1A", &OCR1A, 2},
+   {"OCR3A", &OCR3A, 2}, {"OCR2", &OCR2, 1}, {"TCCR1A", &TCCR1A, 1},
+   {"TCCR1B", &TCCR1B, 1}, {"TCCR3A", &TCCR3A, 1}, {"TCCR3B", &TCCR3B, 1},
+};
+#define HAL_WATCHES (sizeof(watch) / sizeof(watch[0]))
+
+static FILE *trace;
+static uint8_t trace_spi;
+static hal_hook_t hook;
+
+//a timer interrupt source, due is the cycle it next fires on
+typedef struct
+{
+   uint64_t due;
+   uint32_t period;
+} hal_timer_t;
+
+static hal_timer_t t0, t1, t2, t3;
+
+static const uint16_t prescale[8] = {0, 1, 8, 64, 256, 1024, 0, 0};
+
+/*********************************************************************/
+/*                             hal_trace                             */
+/*Prints every change of the listed registers (comma separated, NULL */
+/*for all of them, "SPI" for the bytes sent) to f as                 */
+/*  <cycle> <register> <value>                                       */
+/*********************************************************************/
+
+void hal_trace(FILE *f, const char *regs)
+{
+   uint8_t i;
+
+   trace = f;
+   trace_spi = !regs || strstr(regs, "SPI");
+   for (i = 0; i < HAL_WATCHES; i++)
+   {
+      const char *p = regs;
+      size_t n = strlen(watch[i].name);
+
+      watch[i].on = !regs;
+      while (p && (p = strstr(p, watch[i].name)))
+      { //whole names only, OCR2 must not match OCR2x
+         if ((p == regs || p[-1] == ',') && (p[n] == ',' || p[n] == '\0'))
+            watch[i].on = 1;
+         p += n;
+      }
+      watch[i].last = watch[i].size == 1 ? *(volatile uint8_t *)watch[i].reg : *(volatile uint16_t *)watch[i].reg;
+   }
+}
+
+/*********************************************************************/
+/*                             hal_hook                              */
+/*Calls fn with the register and its new value every time one of the */
+/*watched registers changes, NULL turns it off                       */
+/*********************************************************************/
+
+void hal_hook(hal_hook_t fn)
+{
+   hook = fn;
+}
+
+/*********************************************************************/
+/*                             hal_wait_set                          */
+/*loop_until_bit_is_set(). The firmware only waits for SPIF, a byte  */
+/*takes 16 cycles at clk/2 and nothing else can happen meanwhile, so */
+/*the byte in SPDR goes out and hal_spi_in comes back at once        */
+/*********************************************************************/
+
+void hal_wait_set(volatile uint8_t *reg, uint8_t bit)
+{
+   if (reg == &SPSR && bit == SPIF)
+   {
+      if (trace && trace_spi)
+         fprintf(trace, "%llu SPI %02x\n", (unsigned long long)hal_cycles, SPDR);
+      SPDR = hal_spi_in;
+   }
+   *reg |= _BV(bit);
+}
+
+static void trace_changes(void)
+{
+   uint8_t i;
+   uint16_t v;
+
+   if (!trace && !hook)
+      return;
+   for (i = 0; i < HAL_WATCHES; i++)
+   {
+      v = watch[i].size == 1 ? *(volatile uint8_t *)watch[i].reg : *(volatile uint16_t *)watch[i].reg;
+      if (v != watch[i].last)
+      {
+         if (trace && watch[i].on)
+            fprintf(trace, "%llu %s %0*x\n", (unsigned long long)hal_cycles, watch[i].name, watch[i].size * 2, v);
+         if (hook)
+            hook(watch[i].reg, v);
+         watch[i].last = v;
+      }
+   }
+}
+
+//next due cycle of a timer from its current period, 0 stops it
+static void timer_update(hal_timer_t *t, uint32_t period)
+{
+   if (period == 0)
+      t->due = HAL_NEVER;
+   else if (t->due == HAL_NEVER || period != t->period)
+      t->due = hal_cycles + period; //started or retuned, count from now
+   t->period = period;
+}
+
+static void timers_update(void)
+{
+   //Timer0 runs from the 32.768kHz crystal, one overflow per 256 counts
+   timer_update(&t0, ((TCCR0 & 0x07) && (TIMSK & _BV(TOIE0))) ? (uint32_t)(F_CPU / 128) : 0);
+   timer_update(&t2, (TIMSK & _BV(TOIE2)) ? 256UL * prescale[TCCR2 & 0x07] : 0);
+   timer_update(&t1, (TIMSK & _BV(OCIE1A)) && TIMER1_COMPA_vect ? (OCR1A + 1UL) * prescale[TCCR1B & 0x07] : 0);
+   timer_update(&t3, (ETIMSK & _BV(OCIE3A)) && TIMER3_COMPA_vect ? (OCR3A + 1UL) * prescale[TCCR3B & 0x07] : 0);
+}
+
+//runs an ISR the way the hardware does, with the I bit cleared
+static void raise(void (*vector)(void))
+{
+   uint8_t sreg = SREG;
+
+   SREG &= ~_BV(SREG_I);
+   vector();
+   SREG = sreg;
+   trace_changes();
+}
+
+/*********************************************************************/
+/*                             hal_reset                             */
+/*Power on: every register back to its reset value, the timers       */
+/*stopped and the clock at cycle 0. hal_trace(), hal_hook() and      */
+/*hal_spi_in are the simulator's settings and stay as they are.      */
+/*********************************************************************/
+
+void hal_reset(void)
+{
+   PORTA = PORTB = PORTC = PORTD = PORTE = PORTF = 0;
+   DDRA = DDRB = DDRC = DDRD = DDRE = DDRF = 0;
+   PINA = PINB = PINC = PIND = PINE = PINF = 0xFF; //released, the pullups
+   SREG = ASSR = TIMSK = ETIMSK = 0;
+   TCCR0 = TCNT0 = TCCR2 = TCNT2 = OCR2 = 0;
+   TCCR1A = TCCR1B = TCCR1C = 0;
+   TCNT1 = OCR1A = OCR1C = 0;
+   TCCR3A = TCCR3B = TCCR3C = 0;
+   TCNT3 = OCR3A = 0;
+   SPCR = SPSR = SPDR = 0;
+   memset(&t0, 0, sizeof(t0));
+   memset(&t1, 0, sizeof(t1));
+   memset(&t2, 0, sizeof(t2));
+   memset(&t3, 0, sizeof(t3));
+   hal_cycles = 0;
+   trace_changes();
+}
+
+/*********************************************************************/
+/*                             hal_run                               */
+/*Advances the simulated clock by cycles. loop, the body of the      */
+/*firmware main loop, runs once before every interrupt, so main gets */
+/*the CPU between ISRs as it would on the target (in zero time).     */
+/*********************************************************************/
+
+void hal_run(uint64_t cycles, void (*loop)(void))
+{
+   uint64_t end = hal_cycles + cycles;
+   hal_timer_t *next;
+
+   for (;;)
+   {
+      if (loop)
+      { //main may retune the timers
+         loop();
+         trace_changes();
+      }
+      timers_update();
+
+      next = &t0;
+      if (t1.due < next->due)
+         next = &t1;
+      if (t2.due < next->due)
+         next = &t2;
+      if (t3.due < next->due)
+         next = &t3;
+      if (next->due > end)
+      {
+         hal_cycles = end;
+         return;
+      }
+
+      hal_cycles = next->due;
+      next->due += next->period;
+      TCNT2 = hal_cycles / (prescale[TCCR2 & 0x07] ? prescale[TCCR2 & 0x07] : 1);
+      if (!(SREG & _BV(SREG_I)))
+         continue; //interrupts off, nothing fires
+      if (next == &t0)
+         raise(TIMER0_OVF_vect);
+      else if (next == &t1)
+         raise(TIMER1_COMPA_vect);
+      else if (next == &t2)
+         raise(TIMER2_OVF_vect);
+      else
+         raise(TIMER3_COMPA_vect);
+   }
+}
@@ -0,0 +1,106 @@
+//Host backend of hal.h
+//Stands in for <avr/io.h>, <avr/interrupt.h> and <avr/pgmspace.h> when the
+//firmware is built for Linux. Only the registers and bits the firmware uses
+//are here, with the ATmega128 bit numbers. hal_host.c owns the registers
+//and runs the timers, SPI and ISRs against a simulated CPU clock.
+#include <stdint.h>
+#include <stdio.h>
+
+#define HAL_REG8(r) extern volatile uint8_t r;
+#define HAL_REG16(r) extern volatile uint16_t r;
+HAL_REG8(PORTA) HAL_REG8(PORTB) HAL_REG8(PORTC) HAL_REG8(PORTD) HAL_REG8(PORTE) HAL_REG8(PORTF)
+HAL_REG8(DDRA) HAL_REG8(DDRB) HAL_REG8(DDRC) HAL_REG8(DDRD) HAL_REG8(DDRE) HAL_REG8(DDRF)
+HAL_REG8(PINA) HAL_REG8(PINB) HAL_REG8(PINC) HAL_REG8(PIND) HAL_REG8(PINE) HAL_REG8(PINF)
+HAL_REG8(SREG) HAL_REG8(ASSR) HAL_REG8(TIMSK) HAL_REG8(ETIMSK)
+HAL_REG8(TCCR0) HAL_REG8(TCNT0) HAL_REG8(TCCR2) HAL_REG8(TCNT2) HAL_REG8(OCR2)
+HAL_REG8(TCCR1A) HAL_REG8(TCCR1B) HAL_REG8(TCCR1C) HAL_REG16(TCNT1) HAL_REG16(OCR1A) HAL_REG16(OCR1C)
+HAL_REG8(TCCR3A) HAL_REG8(TCCR3B) HAL_REG8(TCCR3C) HAL_REG16(TCNT3) HAL_REG16(OCR3A)
+HAL_REG8(SPCR) HAL_REG8(SPSR) HAL_REG8(SPDR)
+
+//port bits
+#define PB0 0
+#define PB4 4
+#define PB5 5
+#define PB6 6
+#define PB7 7
+#define PC0 0
+#define PC5 5
+#define PC6 6
+#define PC7 7
+#define PD2 2
+#define PD6 6
+#define PD7 7
+#define PE0 0
+#define PE1 1
+#define PE2 2
+#define PE3 3
+#define PE4 4
+#define PE5 5
+#define PE6 6
+
+//timer bits
+#define AS0 3
+#define TOIE0 0
+#define OCIE1A 4
+#define TOIE2 6
+#define OCIE3A 4
+#define CS00 0
+#define CS10 0
+#define CS11 1
+#define CS12 2
+#define WGM12 3
+#define COM1C0 2
+#define CS20 0
+#define CS21 1
+#define CS22 2
+#define WGM20 6
+#define WGM21 3
+#define COM20 4
+#define COM21 5
+#define CS30 0
+#define CS31 1
+#define CS32 2
+#define WGM30 0
+#define WGM32 3
+#define COM3A0 6
+#define COM3A1 7
+
+//SPI bits
+#define SPE 6
+#define MSTR 4
+#define SPIE 7
+#define SPI2X 0
+#define SPIF 7
+
+#define _BV(b) (1 << (b))
+#define bit_is_set(r, b) ((r) & _BV(b))
+#define bit_is_clear(r, b) (!((r) & _BV(b)))
+#define loop_until_bit_is_set(r, b) hal_wait_set(&(r), b)
+
+//interrupts, the I bit of SREG is only looked at by the simulator
+#define SREG_I 7
+#define ISR(vector) void vector(void)
+#define cli() (SREG &= ~_BV(SREG_I))
+#define sei() (SREG |= _BV(SREG_I))
+
+//vectors the simulator knows how to raise
+void TIMER0_OVF_vect(void);
+void TIMER2_OVF_vect(void);
+void TIMER1_COMPA_vect(void);
+void TIMER3_COMPA_vect(void);
+
+//flash is ordinary memory
+#define PROGMEM
+#define pgm_read_byte(p) (*(const uint8_t *)(p))
+#define pgm_read_word(p) (*(const uint16_t *)(p))
+#define pgm_read_ptr(p) (*(const void *const *)(p))
+
+//simulator, see hal_host.c
+extern uint64_t hal_cycles;   //CPU cycles since reset
+extern uint8_t hal_spi_in;    //byte the SPI slaves shift back (the encoders)
+typedef void (*hal_hook_t)(volatile void *reg, uint16_t value);
+void hal_trace(FILE *f, const char *regs);
+void hal_hook(hal_hook_t fn);
+void hal_wait_set(volatile uint8_t *reg, uint8_t bit);
+void hal_reset(void);
+void hal_run(uint64_t cycles, void (*loop)(void));
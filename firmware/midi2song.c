@@ -0,0 +1,596 @@
+/*********************************************************************/
+/*                   MIDI file to song compiler                      */
+/* Converts Standard MIDI Files (format 0 or 1) to the packed song   */
+/* events of music.h, ready to paste into songs.c. Runs on the build */
+/* machine (make midi2song).                                         */
+/*                                                                   */
+/*  midi2song [-j jobs] [-o dir] [-t track,track] file.mid...        */
+/*    -j  files converted at once, one worker process each, default  */
+/*        the number of CPUs                                         */
+/*    -o  directory the .c files go to, default the current one      */
+/*    -t  tracks (0 based, as in the file) played on channels 1 and  */
+/*        2, default the first two tracks with notes. -1 leaves a    */
+/*        channel out                                                */
+/*                                                                   */
+/* Each file.mid becomes file.c holding file_ch1[]/file_ch2[] and    */
+/* the song_table[] entry for them in a comment. A line per file,    */
+/* in the order given, then the totals go to stdout:                 */
+/*  file,ch1_events,ch2_events,bytes,dropped,folded,cut              */
+/*  dropped  notes under a higher one on the same channel, the       */
+/*           channels are monophonic                                 */
+/*  folded   notes moved by octaves into C0-B8                       */
+/*  cut      64ths left out past the 255 events a channel can hold   */
+/*                                                                   */
+/* Times are quantized to the 64th notes of the song player, a       */
+/* quarter is 16. Tempo changes are not kept, the first tempo is     */
+/* reported so music_tempo() can be set to match. Repeated phrases   */
+/* right after each other become REPEAT events.                      */
+/*********************************************************************/
+#include <ctype.h>
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "music.h"
+
+#define MIDI_TRACKS 64
+#define MIDI_C0 12       //MIDI note of semitone 0 (C0)
+#define SONG_EVENTS 255  //a REPEAT or seek can reach event 254
+#define SONG_MAX_BEATS 65535
+#define REPORT_LEN 256
+
+typedef struct
+{
+   uint32_t on, off; //64ths
+   uint8_t note;     //semitone, C0 = 0
+} midi_note_t;
+
+typedef struct
+{
+   midi_note_t *notes;
+   uint32_t n, size;
+} midi_track_t;
+
+//one converted file
+typedef struct
+{
+   midi_track_t track[MIDI_TRACKS];
+   uint16_t tracks, division;
+   uint32_t tempo;            //us per quarter, first one in the file
+   uint32_t dropped, folded, cut;
+   uint8_t ev[2][SONG_EVENTS * 2];
+   uint16_t len[2];           //events, END included
+} song_file_t;
+
+static int track_map[2] = {-2, -2}; //-2 picks a track with notes
+
+static uint32_t be(const uint8_t *p, int bytes)
+{
+   uint32_t v = 0;
+
+   while (bytes--)
+      v = v << 8 | *p++;
+   return v;
+}
+
+//variable length quantity, 0 and *p past end on a short read
+static uint32_t vlq(const uint8_t **p, const uint8_t *end)
+{
+   uint32_t v = 0;
+   uint8_t b, i;
+
+   for (i = 0; i < 4 && *p < end; i++)
+   {
+      b = *(*p)++;
+      v = v << 7 | (b & 0x7F);
+      if (!(b & 0x80))
+         return v;
+   }
+   *p = end;
+   return v;
+}
+
+static int add_note(song_file_t *f, midi_track_t *t, uint32_t on, uint32_t off, uint8_t key)
+{
+   int n = key - MIDI_C0;
+   midi_note_t *m;
+
+   //ticks to 64ths, rounded, a note keeps at least one
+   on = ((uint64_t)on * 16 + f->division / 2) / f->division;
+   off = ((uint64_t)off * 16 + f->division / 2) / f->division;
+   if (off <= on)
+      off = on + 1;
+   if (off > SONG_MAX_BEATS)
+      return 0;
+   if (n < 0 || n >= NUM_NOTES)
+   {
+      while (n < 0)
+         n += 12;
+      while (n >= NUM_NOTES)
+         n -= 12;
+      f->folded++;
+   }
+   if (t->n == t->size)
+   {
+      t->size = t->size ? t->size * 2 : 256;
+      t->notes = realloc(t->notes, t->size * sizeof(*t->notes));
+      if (!t->notes)
+         return -1;
+   }
+   m = &t->notes[t->n++];
+   m->on = on;
+   m->off = off;
+   m->note = n;
+   return 0;
+}
+
+static int parse_track(song_file_t *f, midi_track_t *t, const uint8_t *p, const uint8_t *end)
+{
+   uint32_t tick = 0, on[16][128], len;
+   uint8_t held[16][128], status = 0, type, ch, key;
+
+   memset(held, 0, sizeof(held));
+   while (p < end)
+   {
+      tick += vlq(&p, end);
+      if (p >= end)
+         break;
+      if (*p & 0x80)
+         status = *p++;
+      else if (!status)
+         return -1; //running status with nothing to run on
+      type = status & 0xF0;
+      ch = status & 0x0F;
+      if (status == 0xFF)
+      { //meta
+         if (p >= end)
+            return -1;
+         type = *p++;
+         len = vlq(&p, end);
+         if (len > (uint32_t)(end - p))
+            return -1;
+         if (type == 0x51 && len == 3 && !f->tempo)
+            f->tempo = be(p, 3);
+         if (type == 0x2F)
+            break;
+         p += len;
+         status = 0;
+         continue;
+      }
+      if (status == 0xF0 || status == 0xF7)
+      { //sysex
+         len = vlq(&p, end);
+         if (len > (uint32_t)(end - p))
+            return -1;
+         p += len;
+         status = 0;
+         continue;
+      }
+      if (type == 0xF0)
+         return -1; //system messages do not belong in a file
+      if (type == 0xC0 || type == 0xD0)
+      {
+         p++;
+         continue;
+      }
+      if (end - p < 2)
+         return -1;
+      key = p[0] & 0x7F;
+      if (ch != 9 && (type == 0x90 || type == 0x80))
+      { //notes, channel 10 is drums
+         if (type == 0x90 && p[1])
+         {
+            if (!held[ch][key]++)
+               on[ch][key] = tick;
+         }
+         else if (held[ch][key] && !--held[ch][key])
+         {
+            if (add_note(f, t, on[ch][key], tick, key))
+               return -1;
+         }
+      }
+      p += 2;
+   }
+   for (ch = 0; ch < 16; ch++) //notes never let go end with the track
+      for (key = 0; key < 128; key++)
+         if (held[ch][key] && add_note(f, t, on[ch][key], tick, key))
+            return -1;
+   return 0;
+}
+
+static int parse_midi(song_file_t *f, const uint8_t *data, size_t size)
+{
+   const uint8_t *p = data, *end = data + size;
+   uint32_t len;
+   uint16_t tracks;
+
+   if (size < 14 || memcmp(p, "MThd", 4) || be(p + 4, 4) < 6)
+      return -1;
+   tracks = be(p + 10, 2);
+   f->division = be(p + 12, 2);
+   if (!f->division || f->division & 0x8000)
+      return -1; //SMPTE time has no beats to quantize to
+   if (be(p + 4, 4) > size - 8)
+      return -1;
+   p += 8 + be(p + 4, 4);
+   while (f->tracks < tracks && f->tracks < MIDI_TRACKS && end - p >= 8)
+   {
+      len = be(p + 4, 4);
+      if (len > (uint32_t)(end - p - 8))
+         return -1;
+      if (!memcmp(p, "MTrk", 4))
+      {
+         if (parse_track(f, &f->track[f->tracks], p + 8, p + 8 + len))
+            return -1;
+         f->tracks++;
+      }
+      p += 8 + len;
+   }
+   return 0;
+}
+
+static void put(song_file_t *f, int c, uint8_t op, uint8_t arg)
+{
+   f->ev[c][f->len[c] * 2] = op;
+   f->ev[c][f->len[c] * 2 + 1] = arg;
+   f->len[c]++;
+}
+
+static int same(const uint8_t *a, const uint8_t *b, int events)
+{
+   return !memcmp(a, b, events * 2);
+}
+
+//packs the notes of one track into channel c, the highest note sounding
+//wins. Returns -1 out of memory
+static int pack(song_file_t *f, int c, midi_track_t *t)
+{
+   uint32_t beats = 0, n = 0, size = 0, i, k, run, last_repeat = 0;
+   int16_t *pitch;   //per 64th, -1 for a rest
+   uint8_t *strike;  //1 where the winning note starts
+   uint8_t *ev = NULL;
+   int16_t p;
+   int repeats, best, best_len;
+
+   for (i = 0; i < t->n; i++)
+      if (t->notes[i].off > beats)
+         beats = t->notes[i].off;
+   pitch = malloc((beats + 1) * sizeof(*pitch));
+   strike = calloc(beats + 1, 1);
+   if (!pitch || !strike)
+      return -1;
+   for (i = 0; i < beats; i++)
+      pitch[i] = -1;
+   for (i = 0; i < t->n; i++)
+      for (k = t->notes[i].on; k < t->notes[i].off; k++)
+         if (t->notes[i].note > pitch[k])
+            pitch[k] = t->notes[i].note;
+   for (i = 0; i < t->n; i++)
+   {
+      if (pitch[t->notes[i].on] == t->notes[i].note)
+         strike[t->notes[i].on] = 1;
+      else
+         f->dropped++;
+   }
+
+   //a note or rest per run of one pitch, at most 255 64ths each
+   for (i = 0; i < beats; i += run)
+   {
+      p = pitch[i];
+      for (run = 1; i + run < beats && run < 255 && pitch[i + run] == p && !strike[i + run]; run++)
+         ;
+      if (n == size)
+      {
+         size = size ? size * 2 : 256;
+         ev = realloc(ev, size * 2);
+         if (!ev)
+            return -1;
+      }
+      ev[n * 2] = p < 0 ? SONG_REST : p;
+      ev[n * 2 + 1] = run;
+      n++;
+   }
+   free(pitch);
+   free(strike);
+
+   //a block that follows itself straight away becomes a REPEAT, the longest
+   //saving first. The player has one repeat counter, so a repeated block
+   //cannot hold a REPEAT
+   for (i = 0; i < n && f->len[c] < SONG_EVENTS - 1;)
+   {
+      best = 0;
+      best_len = 0;
+      for (run = 2; run <= f->len[c] - last_repeat; run++)
+      {
+         for (repeats = 0; repeats < 0x7D && i + (repeats + 1) * run <= n &&
+                           same(&f->ev[c][(f->len[c] - run) * 2], &ev[(i + repeats * run) * 2], run);
+              repeats++)
+            ;
+         if (repeats * (int)run > best * best_len)
+         {
+            best = repeats;
+            best_len = run;
+         }
+      }
+      if (best)
+      {
+         put(f, c, SONG_REPEAT | best, f->len[c] - best_len);
+         last_repeat = f->len[c];
+         i += best * best_len;
+      }
+      else
+      {
+         put(f, c, ev[i * 2], ev[i * 2 + 1]);
+         i++;
+      }
+   }
+   for (; i < n; i++)
+      f->cut += ev[i * 2 + 1];
+   put(f, c, SONG_END, 0);
+   free(ev);
+   return 0;
+}
+
+//C identifier from the file name
+static void song_name(char *name, size_t size, const char *path)
+{
+   const char *base = strrchr(path, '/');
+   size_t i;
+
+   base = base ? base + 1 : path;
+   for (i = 0; i + 1 < size && base[i] && base[i] != '.'; i++)
+      name[i] = isalnum((unsigned char)base[i]) ? base[i] : '_';
+   name[i] = 0;
+   if (isdigit((unsigned char)name[0]))
+      name[0] = '_';
+}
+
+static const char *const note_names[12] = {"C", "Db", "D", "Eb", "E", "F", "Gb", "G", "Ab", "A", "Bb", "B"};
+
+static void write_events(FILE *out, const char *name, int c, const uint8_t *ev, int len)
+{
+   int i;
+   uint8_t op, arg;
+
+   fprintf(out, "const uint8_t %s_ch%d[] PROGMEM = {", name, c + 1);
+   for (i = 0; i < len; i++)
+   {
+      op = ev[i * 2];
+      arg = ev[i * 2 + 1];
+      fprintf(out, "%s", i % 4 ? ", " : (i ? ",\n   " : "\n   "));
+      if (op < NUM_NOTES)
+         fprintf(out, "NOTE(%s, %d, %d)", note_names[op % 12], op / 12, arg);
+      else if (op == SONG_REST)
+         fprintf(out, "REST(%d)", arg);
+      else if (op == SONG_END)
+         fprintf(out, "END");
+      else
+         fprintf(out, "REPEAT(%d, %d)", op & ~SONG_REPEAT, arg);
+   }
+   fprintf(out, "\n};\n\n");
+}
+
+//one file, the report line goes to report. Returns nonzero on failure
+static int convert(const char *path, const char *dir, char *report)
+{
+   static song_file_t f;
+   char name[64], out_path[1024];
+   uint8_t *data;
+   long size;
+   FILE *in, *out;
+   int c, t, used, ret = -1;
+
+   memset(&f, 0, sizeof(f));
+   in = fopen(path, "rb");
+   if (!in)
+   {
+      snprintf(report, REPORT_LEN, "%s: %s", path, strerror(errno));
+      return -1;
+   }
+   fseek(in, 0, SEEK_END);
+   size = ftell(in);
+   rewind(in);
+   data = malloc(size > 0 ? size : 1);
+   if (!data || fread(data, 1, size, in) != (size_t)size)
+   {
+      fclose(in);
+      free(data);
+      snprintf(report, REPORT_LEN, "%s: read error", path);
+      return -1;
+   }
+   fclose(in);
+   if (parse_midi(&f, data, size))
+   {
+      free(data);
+      snprintf(report, REPORT_LEN, "%s: not a Standard MIDI File this can read", path);
+      return -1;
+   }
+   free(data);
+
+   //tracks to channels
+   used = -1;
+   for (c = 0; c < 2; c++)
+   {
+      t = track_map[c];
+      if (t == -2)
+      {
+         for (t = used + 1; t < f.tracks && !f.track[t].n; t++)
+            ;
+         if (t >= f.tracks)
+            t = -1;
+         used = t;
+      }
+      if (t >= 0 && t < f.tracks)
+      {
+         if (pack(&f, c, &f.track[t]))
+         {
+            snprintf(report, REPORT_LEN, "%s: out of memory", path);
+            goto done;
+         }
+      }
+   }
+
+   song_name(name, sizeof(name), path);
+   snprintf(out_path, sizeof(out_path), "%s/%s.c", dir, name);
+   out = fopen(out_path, "w");
+   if (!out)
+   {
+      snprintf(report, REPORT_LEN, "%.200s: %s", out_path, strerror(errno));
+      goto done;
+   }
+   fprintf(out, "//%s, converted by midi2song", path);
+   if (f.tempo)
+      fprintf(out, ", music_tempo(%lu)", (unsigned long)((600000000ULL + f.tempo / 2) / f.tempo));
+   fprintf(out, "\n");
+   for (c = 0; c < 2; c++)
+      if (f.len[c])
+         write_events(out, name, c, f.ev[c], f.len[c]);
+   fprintf(out, "//song_table[] entry\n//{{");
+   for (c = 0; c < 2; c++)
+      fprintf(out, f.len[c] ? "%s%s_ch%d" : "%sNULL", c ? ", " : "", name, c + 1);
+   fprintf(out, "}, {%u, %u}},\n", f.len[0], f.len[1]);
+   fclose(out);
+
+   snprintf(report, REPORT_LEN, "%s,%u,%u,%u,%lu,%lu,%lu", path, f.len[0], f.len[1], 2 * (f.len[0] + f.len[1]),
+            (unsigned long)f.dropped, (unsigned long)f.folded, (unsigned long)f.cut);
+   ret = 0;
+done:
+   for (t = 0; t < f.tracks; t++)
+      free(f.track[t].notes);
+   return ret;
+}
+
+//worker for files[i], the report comes back through a pipe
+typedef struct
+{
+   pid_t pid;
+   int fd;
+   int file;
+} worker_t;
+
+int main(int argc, char **argv)
+{
+   const char *dir = ".";
+   char (*report)[REPORT_LEN];
+   long jobs = sysconf(_SC_NPROCESSORS_ONLN);
+   unsigned long events[2] = {0, 0}, bytes = 0;
+   unsigned u[3];
+   worker_t *w;
+   int opt, files, next, running, i, status, fd[2], failed = 0;
+   ssize_t got;
+   pid_t pid;
+
+   while ((opt = getopt(argc, argv, "j:o:t:")) != -1)
+   {
+      switch (opt)
+      {
+      case 'j':
+         jobs = strtol(optarg, NULL, 0);
+         break;
+      case 'o':
+         dir = optarg;
+         break;
+      case 't':
+         if (sscanf(optarg, "%d,%d", &track_map[0], &track_map[1]) != 2)
+            optind = argc;
+         break;
+      default:
+         optind = argc;
+         break;
+      }
+   }
+   files = argc - optind;
+   if (files < 1)
+   {
+      fprintf(stderr, "usage: %s [-j jobs] [-o dir] [-t track,track] file.mid...\n", argv[0]);
+      return 1;
+   }
+   if (jobs < 1)
+      jobs = 1;
+   report = calloc(files, sizeof(*report));
+   w = calloc(jobs, sizeof(*w));
+   if (!report || !w)
+   {
+      perror("midi2song");
+      return 1;
+   }
+
+   for (next = 0, running = 0; next < files || running;)
+   {
+      if (next < files && running < jobs)
+      {
+         if (pipe(fd))
+         {
+            perror("midi2song");
+            return 1;
+         }
+         pid = fork();
+         if (pid < 0)
+         {
+            perror("midi2song");
+            return 1;
+         }
+         if (!pid)
+         {
+            char line[REPORT_LEN];
+            int ret;
+
+            close(fd[0]);
+            ret = convert(argv[optind + next], dir, line);
+            if (write(fd[1], line, strlen(line) + 1) < 0)
+               ret = -1;
+            _exit(ret ? 1 : 0);
+         }
+         close(fd[1]);
+         for (i = 0; w[i].pid; i++)
+            ;
+         w[i].pid = pid;
+         w[i].fd = fd[0];
+         w[i].file = next++;
+         running++;
+         continue;
+      }
+      pid = wait(&status);
+      for (i = 0; i < jobs && w[i].pid != pid; i++)
+         ;
+      if (i == jobs)
+         continue;
+      got = read(w[i].fd, report[w[i].file], REPORT_LEN - 1);
+      if (got <= 0)
+         snprintf(report[w[i].file], REPORT_LEN, "%s: worker died", argv[optind + w[i].file]);
+      if (!WIFEXITED(status) || WEXITSTATUS(status))
+      {
+         fprintf(stderr, "midi2song: %s\n", report[w[i].file]);
+         report[w[i].file][0] = 0;
+         failed++;
+      }
+      close(w[i].fd);
+      w[i].pid = 0;
+      running--;
+   }
+
+   printf("file,ch1_events,ch2_events,bytes,dropped,folded,cut\n");
+   for (i = 0; i < files; i++)
+   {
+      char *p;
+
+      if (!report[i][0])
+         continue;
+      printf("%s\n", report[i]);
+      p = strchr(report[i], ',');
+      if (p && sscanf(p, ",%u,%u,%u", &u[0], &u[1], &u[2]) == 3)
+      {
+         events[0] += u[0];
+         events[1] += u[1];
+         bytes += u[2];
+      }
+   }
+   printf("total %d files, %lu + %lu events, %lu bytes of flash, %d failed\n", files - failed, events[0], events[1],
+          bytes, failed);
+   free(report);
+   free(w);
+   return failed ? 2 : 0;
+}
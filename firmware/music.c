@@ -6,15 +6,9 @@
 /* This file should include everything you need to set up and use    */
 /*songs for your ECE473 alarm clock.  Each function has a description*/
 /*so you know how to use it, but all you should need to do is:       */
-/*  0)Add the following to your Timer0 overflow interrupt (assuming  */
-/*      interrupt is 128 times/second):
-  ms++;
-  if(ms % 8 == 0) {
-    //for note duration (64th notes) 
-    beat++;
-  }                                                                  */
-/*      ms can be changed for any counter variable, if you have one  */
-/*      already. beat, however, must stay.                           */
+/*  0)Call music_clock() from your Timer0 overflow interrupt        */
+/*      (assuming interrupt is 128 times/second). It calls           */
+/*      music_tick() once per 64th note at the music_tempo() BPM.    */
 /*  1)Change the #define values below for mute, unmute, and ALARM_PIN*/
 /*      to the values needed for your setup.  If you use a different */
 /*      port, as well as different pins, you'll have to manually     */
@@ -34,12 +28,15 @@
 /*ones with the class! Have fun!                                     */
 /*             -Kellen Arb                                           */
 /*********************************************************************/
-#include <avr/io.h>
+#include "hal.h"
 #define F_CPU 16000000UL //16Mhz clock
 #include <string.h>
-#include <avr/sfr_defs.h>
 #include "music.h"
-#include <avr/interrupt.h>
+#include "synth.h"
+#include "event.h"
+#include "pattern.h"
+#include "spi.h"
+#include "profile.h"
 
 //Mute is on PORTD
 //set the hex values to set and unset the mute pin
@@ -50,20 +47,18 @@
 //set the hex value for the alarm pin
 //I used PORTD-PIN7
 #define ALARM_PIN 0x80
-#define NUM_SONGS 4
 //set this variable to select the song
-//(0-3, unless you add more)
+//(0 to NUM_SONGS - 1, songs are in songs.c)
 
 #define ALARM_PIN2 0x40 //PORT D pin 6
 
+//clock select bits of TCCR1B and TCCR3B, 0 stops the timer
+#define TONE_CS 0x07
+
 uint8_t song;
 //uint8_t rest_flag;
 /*
 //function prototypes defined here
-void song0(uint16_t note); //Beaver Fight Song
-void song1(uint16_t note); //Tetris Theme (A)
-void song2(uint16_t note); //Mario Bros Theme
-void song3(uint16_t note); 
 void play_song(uint8_t song, uint8_t note);
 void play_rest(uint8_t duration);
 void play_note(char note, uint8_t flat, uint8_t octave, uint8_t duration);
@@ -72,1360 +67,373 @@ void music_on(void);
 void music_init(void);
 */
 
-#define C0 0x1DDC
-#define Db0 0x1C30
-#define D0 0x1A9A
-#define Eb0 0x1919
-#define E0 0x17B2
-#define F0 0x165D
-#define Gb0 0x151D
-#define G0 0x13ED
-#define Ab0 0x12CE
-#define A0 0x11C0
-#define Bb0 0x10C0
-#define B0 0x0FD0
-#define C1 0x0EED
-#define Db1 0x0E16
-#define D1 0x0D4C
-#define Eb1 0x0C8D
-#define E1 0x0BD8
-#define F1 0x0B2E
-#define Gb1 0x0A8D
-#define G1 0x09F6
-#define Ab1 0x0967
-#define A1 0x08DF
-#define Bb1 0x0860
-#define B1 0x07E7
-#define C2 0x0776
-#define Db2 0x070A
-#define D2 0x06A5
-#define Eb2 0x0646
-#define E2 0x05EB
-#define F2 0x0596
-#define Gb2 0x0546
-#define G2 0x04FA
-#define Ab2 0x04B2
-#define A2 0x046F
-#define Bb2 0x042F
-#define B2 0x03F3
-#define C3 0x03BA
-#define Db3 0x0384
-#define D3 0x0352
-#define Eb3 0x0322
-#define E3 0x02F5
-#define F3 0x02CA
-#define Gb3 0x02A2
-#define G3 0x027C
-#define Ab3 0x0258
-#define A3 0x0237
-#define Bb3 0x0217
-#define B3 0x01F9
-#define C4 0x01DC
-#define Db4 0x01C1
-#define D4 0x01A8
-#define Eb4 0x0190
-#define E4 0x017A
-#define F4 0x0164
-#define Gb4 0x0150
-#define G4 0x013D
-#define Ab4 0x012B
-#define A4 0x011B
-#define Bb4 0x010B
-#define B4 0x00FC
-#define C5 0x00ED
-#define Db5 0x00E0
-#define D5 0x00D3
-#define Eb5 0x00C7
-#define E5 0x00BC
-#define F5 0x00B1
-#define Gb5 0x00A7
-#define G5 0x009E
-#define Ab5 0x0095
-#define A5 0x008D
-#define Bb5 0x0085
-#define B5 0x007D
-#define C6 0x0076
-#define Db6 0x006F
-#define D6 0x0069
-#define Eb6 0x0063
-#define E6 0x005D
-#define F6 0x0058
-#define Gb6 0x0053
-#define G6 0x004E
-#define Ab6 0x004A
-#define A6 0x0046
-#define Bb6 0x0042
-#define B6 0x003E
-#define C7 0x003A
-#define Db7 0x0037
-#define D7 0x0034
-#define Eb7 0x0031
-#define E7 0x002E
-#define F7 0x002B
-#define Gb7 0x0029
-#define G7 0x0026
-#define Ab7 0x0024
-#define A7 0x0022
-#define Bb7 0x0020
-#define B7 0x001E
-#define C8 0x001C
-#define Db8 0x001B
-#define D8 0x0019
-#define Eb8 0x0018
-#define E8 0x0015
-#define F8 0x0012
-#define Gb8 0x0010
-#define G8 0x000D
-#define Ab8 0x000B
-#define A8 0x0009
-#define Bb8 0x0007
-#define B8 0x0005
-
-//nest this in an array of 12 different key sets
-//uint16_t C[42] = {C0, D0, E0, F0, G0, A0, B0, C1, D1, E1, F1, G1, A1, B1, C2, D2, E2, F2, G2, A2, B2, C3, D3, E3, F3, G3, A3, B3, C4, D4, E4, F4, G4, A4, B4, C5, D5, E5, F5, G5, A5, B5, C6, D6, E6, F6, G6, A6, B6, C7, D7, E7, F7, G7, A7, B7, C8, D8, E8, F8, G8, A8, B8};
-char C[8] = {'C', 'D', 'E', 'F', 'G', 'A', 'B', 'C'};
-char dorian[8] = {'D', 'E', 'F', 'G', 'A', 'B', 'C', 'D'};
-char phrygian[8] = {'E', 'F', 'G', 'A', 'B', 'C', 'D', 'E'};
-char lydian[8] = {'F', 'G', 'A', 'B', 'C', 'D', 'E', 'F'};
-char mixolydian[8] = {'G', 'A', 'B', 'C', 'D', 'E', 'F', 'G'};
-char aeolian[8] = {'A', 'B', 'C', 'D', 'E', 'F', 'G', 'A'};
-char locrian[8] = {'B', 'C', 'D', 'E', 'F', 'G', 'A', 'B'};
-
-char C_d[8] = {'C', 'B', 'A', 'G', 'F', 'E', 'D', 'C'};
-char dorian_d[8] = {'D', 'C', 'B', 'A', 'G', 'F', 'E', 'D'};
-char phrygian_d[8] = {'E', 'D', 'C', 'B', 'A', 'G', 'F', 'E'};
-char lydian_d[8] = {'F', 'E', 'D', 'C', 'B', 'A', 'G', 'F'};
-char mixolydian_d[8] = {'G', 'F', 'E', 'D', 'C', 'B', 'A', 'G'};
-char aeolian_d[8] = {'A', 'G', 'F', 'E', 'D', 'C', 'B', 'A'};
-char locrian_d[8] = {'B', 'A', 'G', 'F', 'E', 'D', 'C', 'B'};
-
-//char C_d[8] = {'C', 'B', 'A', 'G', 'F', 'E', 'D', 'C'};
+//tuning the notes play in, set by music_tuning()
+const tuning_entry_t *tuning;
+
+//scales as semitone masks from the root, indexed by the scale control
+const uint16_t scale_table[NUM_SCALES - 1] PROGMEM = {
+   0xAB5, //major (ionian)
+   0x6AD, //dorian
+   0x5AB, //phrygian
+   0xAD5, //lydian
+   0x6B5, //mixolydian
+   0x5AD, //natural minor (aeolian)
+   0x56B, //locrian
+   0x9AD, //harmonic minor
+   0xAAD, //melodic minor
+   0x295, //major pentatonic
+   0x4A9, //minor pentatonic
+   0x555, //whole tone
+};
+
+//SCALE_USER, major until music_scale_user() says otherwise
+static uint16_t scale_user = 0xAB5;
 
 //global control consts
-volatile uint8_t switch_ch;
+volatile uint8_t switch_ch = 1; //1 based, the Timer0 ISR indexes arp[] with it
 
-/*********** CHANNNEL ONE ****************/
-volatile uint16_t beat;
-volatile uint16_t max_beat;
+//song position, the arpeggios keep theirs in the step buffer
 volatile uint8_t notes;
 
+//arpeggiator channels, switch_ch selects arp[switch_ch - 1]
+arp_channel_t arp[ARP_CHANNELS];
+
 //arpegiator channel 1 tuning controls
 volatile uint8_t save1;
 volatile uint8_t delete1;
 
-//muscal const ch1
-volatile uint8_t attribute1;
-volatile uint8_t notes_to_play1;
-volatile uint8_t rate1;
-volatile uint8_t steps1;
-volatile uint8_t octave1;
-volatile uint8_t type1;
-
-uint8_t rest_flag;
-
-//UP down and down up behavior                        //added to top of music.c, added to music.h, need to wire
-volatile uint8_t p_flag1;
-volatile uint8_t p_flag2;
-
-/************ CHANNEL TWO *************/
-volatile uint16_t beat2;
-volatile uint16_t max_beat2;
-volatile uint8_t notes2;
-
-//muscal const ch1
-volatile uint8_t attribute2;
-volatile uint8_t notes_to_play2;
-volatile uint8_t rate2;
-volatile uint8_t steps2;
-volatile uint8_t octave2;
-uint8_t rest_flag2;
-volatile uint8_t repeat2;
-volatile uint8_t type2;
-
-//control flags for chopping notes
-uint8_t chop_top1 = 0;
-uint8_t chop_bot1 = 0;
-uint8_t chop_top2 = 0;
-uint8_t chop_bot2 = 0;
-
-//for chopping double root notes.... Jesus this code has turned into a cluster f
-uint8_t octave_flag_up1 = 0;
-uint8_t octave_flag_up2 = 0;
-uint8_t octave_flag_down1 = 0;
-uint8_t octave_flag_down2 = 0;
-
-//arpegiator channel 2 tuning controls
-volatile uint8_t play; //starts playing any savaed sequence
-volatile uint8_t stop; //stops channel two from playing synth returns to normal mode
-volatile uint8_t sequence_to_play[4];
-volatile uint8_t sequence_flag;
-
-//mode variables
-volatile char *mode1;
-volatile char *mode1_d;
-volatile uint8_t modal1;
-
-volatile char *mode2;
-volatile char *mode2_d;
-volatile uint8_t modal2;
-
-void song0(uint16_t note)
-{ //beaver fight song (Max and Kellen)
-   switch (note)
+//tempo of the master clock in tenths of a BPM, set with music_tempo()
+uint16_t tempo = TEMPO_DEFAULT;
+
+//master clock, the fraction of a 64th note (1/65536ths) one Timer0 tick
+//is worth, and how far into the current 64th note we are
+static volatile uint16_t clock_inc = CLOCK_INC(TEMPO_DEFAULT);
+static uint16_t clock_phase;
+#ifdef NOTE_TRACE
+static volatile uint32_t trace_beat; //music_tick() calls since reset
+#endif
+
+//what SEQUENCER_CH compiles from while the pattern runs, see music_update()
+static uint8_t pattern_on;     //pattern_running as of the last music_update()
+static uint8_t pattern_keys;   //keys of the step playing
+static int8_t pattern_shift;   //its octave offset
+
+/*********************************************************************/
+/*                            Song player                            */
+/*The songs are packed events in flash, see music.h for the format  */
+/*and songs.c for the songs.                                         */
+/*********************************************************************/
+typedef struct
+{
+   const uint8_t *events; //event 0 of the song playing
+   const uint8_t *pos;    //next event, NULL when the song has none here
+   uint8_t repeat;        //runs left of the REPEAT being played, 0 when none
+} song_player_t;
+
+static song_player_t song_player[2]; //channels 1 and 2
+
+void song_seek(uint8_t song, uint8_t channel, uint8_t event)
+{
+   //the next song_next() on channel (1 or 2) plays event number event of
+   //song, anything past the end plays as the end. A seek into a repeated
+   //part plays it as many times as from the start
+   song_player_t *p = &song_player[channel - 1];
+   uint8_t len;
+
+   if (song >= NUM_SONGS)
+      song = 0; //defaults to beaver fight song
+   p->events = pgm_read_ptr(&song_table[song].events[channel - 1]);
+   len = pgm_read_byte(&song_table[song].len[channel - 1]);
+   p->pos = NULL;
+   if (!p->events)
+      return;
+   if (event >= len)
+      event = len - 1;
+   p->pos = p->events + 2 * event;
+   p->repeat = 0;
+}
+
+uint8_t song_next(uint8_t channel)
+{
+   //plays the next note or rest of the song on channel, running any
+   //REPEAT and LOOP on the way. Returns 0 at the end of the song
+   song_player_t *p = &song_player[channel - 1];
+   uint8_t op, arg;
+
+   if (!p->pos)
+      return 0;
+   for (;;)
    {
-   case 0:
-      play_note('F', 0, 4, 8);
-      break;
-   case 1:
-      play_note('E', 0, 4, 8);
-      break;
-   case 2:
-      play_note('D', 0, 4, 8);
-      break;
-   case 3:
-      play_note('C', 0, 4, 8);
-      break;
-   case 4:
-      play_note('A', 0, 4, 6);
-      break;
-   case 5:
-      play_note('A', 1, 4, 2);
-      break;
-   case 6:
-      play_note('A', 0, 4, 6);
-      break;
-   case 7:
-      play_note('A', 1, 4, 2);
-      break;
-   case 8:
-      play_note('A', 0, 4, 16);
-      break;
-   case 9:
-      play_note('F', 0, 4, 8);
-      break;
-   case 10:
-      play_note('E', 0, 4, 8);
-      break;
-   case 11:
-      play_note('D', 0, 4, 8);
-      break;
-   case 12:
-      play_note('C', 0, 4, 8);
-      break;
-   case 13:
-      play_note('B', 1, 4, 6);
-      break;
-   case 14:
-      play_note('A', 0, 4, 2);
-      break;
-   case 15:
-      play_note('B', 1, 4, 6);
-      break;
-   case 16:
-      play_note('A', 0, 4, 2);
-      break;
-   case 17:
-      play_note('B', 1, 4, 16);
-      break;
-   case 18:
-      play_note('G', 0, 4, 3);
-      break;
-   case 19:
-      play_rest(1); //rest
-      break;
-   case 20:
-      play_note('G', 0, 4, 7);
-      break;
-   case 21:
-      play_rest(1); //rest
-      break;
-   case 22:
-      play_note('G', 1, 4, 4);
-      break;
-   case 23:
-      play_note('G', 0, 4, 6);
-      break;
-   case 24:
-      play_note('A', 0, 4, 2);
-      break;
-   case 25:
-      play_note('B', 1, 4, 8);
-      break;
-   case 26:
-      play_note('A', 0, 4, 2);
-      break;
-   case 27:
-      play_rest(2);
-      break;
-   case 28:
-      play_note('A', 0, 4, 8);
-      break;
-   case 29:
-      play_note('A', 1, 4, 4);
-      break;
-   case 30:
-      play_note('A', 0, 4, 6);
-      break;
-   case 31:
-      play_note('B', 1, 4, 2);
-      break;
-   case 32:
-      play_note('C', 0, 5, 4);
-      break;
-   case 33:
-      play_note('D', 1, 5, 4);
-      break;
-   case 34:
-      play_note('D', 0, 5, 4);
-      break;
-   case 35:
-      play_note('B', 0, 4, 8);
-      break;
-   case 36:
-      play_note('A', 0, 4, 4);
-      break;
-   case 37:
-      play_note('G', 0, 4, 8);
-      break;
-   case 38:
-      play_note('A', 0, 4, 8);
-      break;
-   case 39:
-      play_note('G', 0, 4, 24);
-      break;
-   case 40:
-      play_rest(8);
-      break;
-   case 41:
-      play_note('F', 0, 4, 8);
-      break;
-   case 42:
-      play_note('E', 0, 4, 8);
-      break;
-   case 43:
-      play_note('D', 0, 4, 8);
-      break;
-   case 44:
-      play_note('C', 0, 4, 8);
-      break;
-   case 45:
-      play_note('A', 0, 4, 6);
-      break;
-   case 46:
-      play_note('A', 1, 4, 2);
-      break;
-   case 47:
-      play_note('A', 0, 4, 6);
-      break;
-   case 48:
-      play_note('A', 1, 4, 2);
-      break;
-   case 49:
-      play_note('A', 0, 4, 16);
-      break;
-   case 50:
-      play_note('F', 0, 4, 8);
-      break;
-   case 51:
-      play_note('G', 1, 4, 8);
-      break;
-   case 52:
-      play_note('G', 0, 4, 8);
-      break;
-   case 53:
-      play_note('D', 0, 4, 8);
-      break;
-   case 54:
-      play_note('B', 1, 4, 6);
-      break;
-   case 55:
-      play_note('A', 0, 4, 2);
-      break;
-   case 56:
-      play_note('B', 1, 4, 6);
-      break;
-   case 57:
-      play_note('A', 0, 4, 2);
-      break;
-   case 58:
-      play_note('B', 1, 4, 16);
-      break; //phrase
-   case 59:
-      play_note('D', 0, 4, 16);
-      break;
-   case 60:
-      play_note('D', 0, 5, 16);
-      break;
-   case 61:
-      play_note('A', 0, 4, 16);
-      break;
-   case 62:
-      play_note('C', 0, 5, 16);
-      break;
-   case 63:
-      play_note('B', 1, 4, 8);
-      break;
-   case 64:
-      play_note('C', 0, 5, 4);
-      break;
-   case 65:
-      play_note('D', 0, 5, 4);
-      break;
-   case 66:
-      play_note('A', 0, 4, 8);
-      break;
-   case 67:
-      play_note('G', 0, 4, 8);
-      break;
-   case 68:
-      play_note('F', 0, 4, 24);
-      break;
-   case 69:
-      play_rest(8);
-      break;
-   default:
+      op = pgm_read_byte(p->pos);
+      arg = pgm_read_byte(p->pos + 1);
+      p->pos += 2;
+      if (op < NUM_NOTES)
+      {
+         play_semitone(channel, op, arg);
+         return 1;
+      }
+      switch (op)
+      {
+      case SONG_REST:
+         play_rest_on(channel, arg);
+         return 1;
+      case SONG_LOOP:
+         p->pos = p->events + 2 * arg;
+         p->repeat = 0;
+         break;
+      case SONG_END:
+         p->pos -= 2; //stay on the end
+         return 0;
+      default: //SONG_REPEAT | n
+         if (!p->repeat)
+            p->repeat = (op & ~SONG_REPEAT) + 1;
+         if (--p->repeat)
+            p->pos = p->events + 2 * arg;
+      }
+   }
+}
+
+void play_song(uint8_t song, uint8_t note)
+{
+   //plays channel 1 of the song one note per call, note 0 starts it over.
+   //At the end notes is set to -1, so the caller's notes++ starts the
+   //song again
+   if (note == 0)
+      song_seek(song, 1, 0);
+   if (!song_next(1))
       notes = -1;
+}
+
+void play_rest_on(uint8_t channel, uint8_t duration)
+{
+   //mute the channel (1 based) for duration
+   //duration is in 64th notes, beats of music_tempo()
+   arp_channel_t *c = &arp[channel - 1];
+
+   c->beat = 0;
+   c->max_beat = duration;
+   c->rest_flag = 1;
+#ifdef TONE_DDS
+   synth_release(channel - 1);
+#endif
+}
+
+void play_rest(uint8_t duration)
+{
+   play_rest_on(1, duration);
+}
+
+void play_rest2(uint8_t duration)
+{
+   play_rest_on(2, duration);
+}
+
+//bargraph SPI callbacks, run around the byte by spi_transfer()
+static void bargraph_select(void)
+{
+   PORTD &= ~(1 << PD2); //enable bar graph display, PORTB, bit 7
+}
+
+static void bargraph_latch(uint8_t in)
+{
+   PORTB |= 0x01;  //HC595 output reg - rising edge...
+   PORTB &= ~0x01; //and falling edge
+   PORTD |= (1 << PD2);
+}
+
+void write_bargraph(uint8_t notes_to_play)
+{
+   //sends it and latches the HC595
+   spi_transfer(notes_to_play, bargraph_select, bargraph_latch);
+}
+
+unsigned int reverseBits(unsigned int num)
+{
+   unsigned int NO_OF_BITS = 8;
+   unsigned int reverse_num = 0, i, temp;
+
+   for (i = 0; i < NO_OF_BITS; i++)
+   {
+      temp = (num & (1 << i));
+      if (temp)
+         reverse_num |= (1 << ((NO_OF_BITS - 1) - i));
    }
-} //song0
 
-void song1(uint16_t note)
-{ //tetris theme (Kellen)
-   switch (note)
+   return reverse_num;
+}
+
+/*********************************************************************/
+/*                         Arpeggio step buffer                      */
+/*The arpeggiate functions no longer touch the tone timers. Whenever */
+/*the notes, steps, octave, type or mode of a channel change,        */
+/*music_update() runs them from the main loop to compile the whole   */
+/*step sequence into seq[]. next_step() then only reads the next     */
+/*entry, so the tone ISR costs the same on every step.               */
+/*********************************************************************/
+
+//step buffer note values, anything below SEQ_NONE is a semitone, C0 = 0
+#define SEQ_NONE 0x7D //the step played nothing and is left out
+#define SEQ_REST 0x7E //rest for the channel rate
+#define SEQ_IDLE 0x7F //rest for one beat, no notes held
+
+//cycle search gives up after this many steps
+#define SEQ_SEARCH (4 * SEQ_LEN)
+
+typedef struct
+{
+   uint8_t note; //semitone, SEQ_REST or SEQ_IDLE
+   uint8_t bar;  //bargraph pattern shown with the step
+} seq_step_t;
+
+typedef struct
+{
+   seq_step_t step[SEQ_LEN];
+   uint8_t len;           //compiled steps, 0 plays an idle rest
+   uint8_t loop;          //playback wraps back to this step
+   uint8_t pos;           //next step to play
+   volatile uint8_t busy; //set while the buffer is being rewritten
+   uint8_t valid;         //cleared to force a recompile
+   uint8_t notes_to_play; //inputs the buffer was compiled from
+   uint8_t steps;
+   uint8_t octave;
+   uint8_t type;
+   uint8_t scale;
+   uint8_t root;
+   uint8_t key[8];        //semitones above C of the octave each key plays
+} arp_seq_t;
+
+//everything the arpeggiate functions carry from one step to the next
+typedef struct
+{
+   uint8_t notes;       //position within the octave
+   uint8_t run_up;      //octave reached by the upward run
+   uint8_t run_down;    //octave reached by the downward run
+   uint8_t rest_up;     //single note input alternates note and rest
+   uint8_t rest_down;
+   uint8_t p_flag;      //up down and down up: 1 while going up
+   uint8_t chop_top;    //drop the highest/lowest note on the turn
+   uint8_t chop_bot;
+   uint8_t octave_up;   //for chopping double root notes
+   uint8_t octave_down;
+} arp_state_t;
+
+static arp_seq_t seq[ARP_CHANNELS];
+
+//what the step being compiled played
+static seq_step_t seq_cur;
+
+static void seq_note(uint8_t n)
+{
+   //note_index() gives NUM_NOTES past octave 8, the top notes of the top
+   //run. OCR 0 there would fire the compare ISR every 64 cycles, so
+   //those steps rest instead
+   seq_cur.note = n < NUM_NOTES ? n : SEQ_REST;
+}
+
+static void seq_key(const arp_seq_t *s, uint8_t k, uint8_t octave)
+{
+   //key k (0 lowest) of the resolved scale, octave counts from its root
+   seq_note(octave * 12 + s->key[k]);
+}
+
+static void seq_rest(void)
+{
+   seq_cur.note = SEQ_REST;
+}
+
+static void seq_idle(void)
+{
+   seq_cur.note = SEQ_IDLE;
+}
+
+static void seq_bar(uint8_t bar)
+{
+   seq_cur.bar = bar;
+}
+
+static void arpeggiateDown(const arp_seq_t *s, arp_state_t *st, uint8_t notes_to_play, uint8_t octave)
+{
+   uint8_t step = s->steps;
+   uint8_t j;
+
+   //mirror the notes to play
+   notes_to_play = reverseBits(notes_to_play);
+
+   if ((s->type == 3 || s->type == 4) && (st->run_down == 1))
+      st->chop_bot = 1;
+
+   if (notes_to_play == 0)
    {
-   case 0:
-      play_note('E', 0, 4, 8);
-      break;
-   case 1:
-      play_note('B', 0, 3, 4);
-      break;
-   case 2:
-      play_note('C', 0, 4, 4);
-      break;
-   case 3:
-      play_note('D', 0, 4, 4);
-      break;
-   case 4:
-      play_note('E', 0, 4, 2);
-      break;
-   case 5:
-      play_note('D', 0, 4, 2);
-      break;
-   case 6:
-      play_note('C', 0, 4, 4);
-      break;
-   case 7:
-      play_note('B', 0, 3, 4);
-      break; //bar
-   case 8:
-      play_note('A', 0, 3, 7);
-      break;
-   case 9:
-      play_rest(1);
-      break;
-   case 10:
-      play_note('A', 0, 3, 4);
-      break;
-   case 11:
-      play_note('C', 0, 4, 4);
-      break;
-   case 12:
-      play_note('E', 0, 4, 8);
-      break;
-   case 13:
-      play_note('D', 0, 4, 4);
-      break;
-   case 14:
-      play_note('C', 0, 4, 4);
-      break; //bar
-   case 15:
-      play_note('B', 0, 3, 12);
-      break;
-   case 16:
-      play_note('C', 0, 4, 4);
-      break;
-   case 17:
-      play_note('D', 0, 4, 8);
-      break;
-   case 18:
-      play_note('E', 0, 4, 8);
-      break; //bar
-   case 19:
-      play_note('C', 0, 4, 8);
-      break;
-   case 20:
-      play_note('A', 0, 3, 7);
-      break;
-   case 21:
-      play_rest(1);
-      break;
-   case 22:
-      play_note('A', 0, 3, 16);
-      break; //bar phrase
-   case 23:
-      play_rest(4);
-      break;
-   case 24:
-      play_note('D', 0, 4, 8);
-      break;
-   case 25:
-      play_note('F', 0, 4, 4);
-      break;
-   case 26:
-      play_note('A', 0, 4, 8);
-      break;
-   case 27:
-      play_note('G', 0, 4, 4);
-      break;
-   case 28:
-      play_note('F', 0, 4, 4);
-      break; //bar
-   case 29:
-      play_note('E', 0, 4, 12);
-      break;
-   case 30:
-      play_note('C', 0, 4, 4);
-      break;
-   case 31:
-      play_note('E', 0, 4, 8);
-      break;
-   case 32:
-      play_note('D', 0, 4, 4);
-      break;
-   case 33:
-      play_note('C', 0, 4, 4);
-      break; //bar
-   case 34:
-      play_note('B', 0, 3, 7);
-      break;
-   case 35:
-      play_rest(1);
-      break;
-   case 36:
-      play_note('B', 0, 3, 4);
-      break;
-   case 37:
-      play_note('C', 0, 4, 4);
-      break;
-   case 38:
-      play_note('D', 0, 4, 8);
-      break;
-   case 39:
-      play_note('E', 0, 4, 8);
-      break;
-   case 40:
-      play_note('C', 0, 4, 8);
-      break;
-   case 41:
-      play_note('A', 0, 3, 7);
-      break;
-   case 42:
-      play_rest(1);
-      break;
-   case 43:
-      play_note('A', 0, 3, 8);
-      break;
-   case 44:
-      play_rest(8);
-      break; //bar phrase
-   case 45:
-      play_note('E', 0, 3, 16);
-      break;
-   case 46:
-      play_note('C', 0, 3, 16);
-      break; //bar
-   case 47:
-      play_note('D', 0, 3, 16);
-      break;
-   case 48:
-      play_note('B', 0, 2, 16);
-      break; //bar
-   case 49:
-      play_note('C', 0, 3, 16);
-      break;
-   case 50:
-      play_note('A', 0, 2, 16);
-      break; //bar
-   case 51:
-      play_note('A', 1, 2, 16);
-      break;
-   case 52:
-      play_note('B', 0, 2, 8);
-      break;
-   case 53:
-      play_rest(8);
-      break; //bar phrase
-   case 54:
-      play_note('E', 0, 3, 16);
-      break;
-   case 55:
-      play_note('C', 0, 3, 16);
-      break; //bar
-   case 56:
-      play_note('D', 0, 3, 16);
-      break;
-   case 57:
-      play_note('B', 0, 2, 16);
-      break; //bar
-   case 58:
-      play_note('C', 0, 3, 8);
-      break;
-   case 59:
-      play_note('E', 0, 3, 8);
-      break;
-   case 60:
-      play_note('A', 0, 3, 16);
-      break; //bar
-   case 61:
-      play_note('A', 1, 3, 16);
-      break;
-   case 62:
-      play_rest(16);
-      break; //bar phrase
-   default:
-      notes = -1;
+      st->run_down = step;
+      st->notes = -1;
+
+      st->octave_down = 0;
+
+      st->chop_top = 0;
+      st->chop_bot = 0;
+
+      if (s->type == 3)
+         st->p_flag = 1;
+      else if (s->type == 4)
+         st->p_flag = 0;
+
+      seq_idle();
+      seq_bar(notes_to_play);
+      return;
    }
-} //song1
 
-void song2(uint16_t note)
-{ //Super Mario Bros Theme (Brian)
-   switch (note)
+   for (j = st->notes; j < 8; j++)
    {
-   case 0:
-      play_note('E', 0, 4, 1);
-      break;
-   case 1:
-      play_rest(1);
-      break;
-   case 2:
-      play_note('E', 0, 4, 3);
-      break;
-   case 3:
-      play_rest(1);
-      break;
-   case 4:
-      play_note('E', 0, 4, 2);
-      break;
-   case 5:
-      play_rest(2);
-      break;
-   case 6:
-      play_note('C', 0, 4, 2);
-      break;
-   case 7:
-      play_note('E', 0, 4, 4);
-      break;
-   case 8:
-      play_note('G', 0, 4, 8);
-      break;
-   case 9:
-      play_note('G', 0, 2, 8);
-      break;
-   case 10:
-      play_rest(8);
-      break;
-   case 11:
-      play_note('C', 0, 4, 5);
-      break;
-   case 12:
-      play_note('G', 0, 3, 2);
-      break;
-   case 13:
-      play_rest(4);
-      break;
-   case 14:
-      play_note('E', 0, 3, 4);
-      break;
-   case 15:
-      play_rest(2);
-      break;
-   case 16:
-      play_note('A', 0, 3, 2);
-      break;
-   case 17:
-      play_rest(2);
-      break;
-   case 18:
-      play_note('B', 0, 3, 2);
-      break;
-   case 19:
-      play_rest(2);
-      break;
-   case 20:
-      play_note('B', 1, 3, 2);
-      break;
-   case 21:
-      play_note('A', 0, 3, 4);
-      break;
-   case 22:
-      play_note('G', 0, 3, 3);
-      break;
-   case 23:
-      play_note('E', 0, 4, 2);
-      break;
-   case 24:
-      play_rest(1);
-      break;
-   case 25:
-      play_note('G', 0, 4, 2);
-      break;
-   case 26:
-      play_note('A', 0, 4, 4);
-      break;
-   case 27:
-      play_note('F', 0, 4, 2);
-      break;
-   case 28:
-      play_note('G', 0, 4, 2);
-      break;
-   case 29:
-      play_rest(2);
-      break;
-   case 30:
-      play_note('E', 0, 4, 2);
-      break;
-   case 31:
-      play_rest(2);
-      break;
-   case 32:
-      play_note('C', 0, 4, 2);
-      break;
-   case 33:
-      play_note('D', 0, 4, 2);
-      break;
-   case 34:
-      play_note('B', 0, 3, 2);
-      break;
-   case 35:
-      play_rest(4);
-      break;
-   case 36:
-      play_note('C', 0, 4, 5);
-      break;
-   case 37:
-      play_rest(2);
-      break;
-   case 38:
-      play_note('G', 0, 3, 2);
-      break;
-   case 39:
-      play_rest(3);
-      break;
-   case 40:
-      play_note('E', 0, 3, 4);
-      break;
-   case 41:
-      play_rest(2);
-      break;
-   case 42:
-      play_note('A', 0, 3, 2);
-      break;
-   case 43:
-      play_rest(2);
-      break;
-   case 44:
-      play_note('B', 0, 3, 2);
-      break;
-   case 45:
-      play_rest(2);
-      break;
-   case 46:
-      play_note('B', 1, 3, 2);
-      break;
-   case 47:
-      play_note('A', 0, 3, 4); //phrase
-      break;
-   case 48:
-      play_note('G', 0, 3, 3);
-      break;
-   case 49:
-      play_note('E', 0, 4, 2);
-      break;
-   case 50:
-      play_rest(1);
-      break;
-   case 51:
-      play_note('G', 0, 4, 2);
-      break;
-   case 52:
-      play_note('A', 0, 4, 4);
-      break;
-   case 53:
-      play_note('F', 0, 4, 2);
-      break;
-   case 54:
-      play_note('G', 0, 4, 2);
-      break;
-   case 55:
-      play_rest(2);
-      break;
-   case 56:
-      play_note('E', 0, 4, 2);
-      break;
-   case 57:
-      play_rest(2);
-      break;
-   case 58:
-      play_note('C', 0, 4, 2);
-      break;
-   case 59:
-      play_note('D', 0, 4, 2);
-      break;
-   case 60:
-      play_note('B', 0, 3, 2);
-      break;
-   case 61:
-      play_rest(8);
-      break;
-   case 62:
-      play_note('G', 0, 4, 2);
-      break;
-   case 63:
-      play_note('G', 1, 4, 2);
-      break;
-   case 64:
-      play_note('F', 0, 4, 2);
-      break;
-   case 65:
-      play_note('E', 1, 4, 2);
-      break;
-   case 66:
-      play_rest(2);
-      break;
-   case 67:
-      play_note('E', 0, 4, 2);
-      break;
-   case 68:
-      play_rest(2);
-      break;
-   case 69:
-      play_note('A', 1, 3, 2);
-      break;
-   case 70:
-      play_note('A', 0, 3, 2);
-      break;
-   case 71:
-      play_note('C', 0, 4, 2);
-      break;
-   case 72:
-      play_rest(2);
-      break;
-   case 73:
-      play_note('A', 0, 3, 2);
-      break;
-   case 74:
-      play_note('C', 0, 4, 2);
-      break;
-   case 75:
-      play_note('D', 0, 4, 2);
-      break;
-   case 76:
-      play_rest(4);
-      break;
-   case 77:
-      play_note('G', 0, 3, 2);
-      break;
-   case 78:
-      play_note('G', 1, 3, 2);
-      break;
-   case 79:
-      play_note('F', 0, 3, 2);
-      break;
-   case 80:
-      play_note('E', 1, 3, 2);
-      break;
-   case 81:
-      play_rest(2);
-      break;
-   case 82:
-      play_note('E', 0, 3, 2);
-      break;
-   case 83:
-      play_rest(2);
-      break;
-   case 84:
-      play_note('G', 0, 4, 2);
-      break;
-   case 85:
-      play_rest(2);
-      break;
-   case 86:
-      play_note('G', 0, 4, 1);
-      break;
-   case 87:
-      play_rest(1);
-      break;
-   case 88:
-      play_note('G', 0, 4, 4);
-      break;
-   case 89:
-      play_rest(8);
-      break;
-   case 90:
-      play_note('G', 0, 4, 2);
-      break;
-   case 91:
-      play_note('G', 1, 4, 2);
-      break;
-   case 92:
-      play_note('F', 0, 4, 2);
-      break;
-   case 93:
-      play_note('E', 1, 4, 2);
-      break;
-   case 94:
-      play_rest(2);
-      break;
-   case 95:
-      play_note('E', 0, 4, 2);
-      break;
-   case 96:
-      play_rest(2);
-      break;
-   case 97:
-      play_note('A', 1, 3, 2);
-      break;
-   case 98:
-      play_note('A', 0, 3, 2);
-      break;
-   case 99:
-      play_note('C', 0, 4, 2);
-      break;
-   case 100:
-      play_rest(2);
-      break;
-   case 101:
-      play_note('A', 0, 3, 2);
-      break;
-   case 102:
-      play_note('C', 0, 4, 2);
-      break;
-   case 103:
-      play_note('D', 0, 4, 2);
-      break;
-   case 104:
-      play_rest(4);
-      break;
-   case 105:
-      play_note('E', 1, 4, 4);
-      break;
-   case 106:
-      play_rest(2);
-      break;
-   case 107:
-      play_note('D', 0, 4, 2);
-      break;
-   case 108:
-      play_rest(4);
-      break;
-   case 109:
-      play_note('C', 0, 4, 4);
-      break;
-   case 110:
-      play_rest(10);
-      break;
-   case 111:
-      play_note('C', 0, 4, 2);
-      break;
-   case 112:
-      play_rest(1);
-      break;
-   case 113:
-      play_note('C', 0, 4, 2);
-      break;
-   case 114:
-      play_rest(2);
-      break;
-   case 115:
-      play_note('C', 0, 4, 2);
-      break;
-   case 116:
-      play_rest(2);
-      break;
-   case 117:
-      play_note('C', 0, 4, 2);
-      break;
-   case 118:
-      play_note('D', 0, 4, 4);
-      break;
-   case 119:
-      play_note('E', 0, 4, 2);
-      break;
-   case 120:
-      play_note('C', 0, 4, 2);
-      break;
-   case 121:
-      play_rest(2);
-      break;
-   case 122:
-      play_note('A', 0, 3, 2);
-      break;
-   case 123:
-      play_note('G', 0, 3, 4);
-      break;
-   case 124:
-      play_rest(4);
-      break;
-   case 125:
-      play_note('C', 0, 4, 2);
-      break;
-   case 126:
-      play_rest(1);
-      break;
-   case 127:
-      play_note('C', 0, 4, 2);
-      break;
-   case 128:
-      play_rest(2);
-      break;
-   case 129:
-      play_note('C', 0, 4, 2);
-      break;
-   case 130:
-      play_rest(2);
-      break;
-   case 131:
-      play_note('C', 0, 4, 2);
-      break;
-   case 132:
-      play_note('D', 0, 4, 2);
-      break;
-   case 133:
-      play_note('E', 0, 4, 2);
-      break;
-   case 134:
-      play_rest(16);
-      break;
-   case 135:
-      play_note('C', 0, 4, 2);
-      break;
-   case 136:
-      play_rest(1);
-      break;
-   case 137:
-      play_note('C', 0, 4, 2);
-      break;
-   case 138:
-      play_rest(2);
-      break;
-   case 139:
-      play_note('C', 0, 4, 2);
-      break;
-   case 140:
-      play_rest(2);
-      break;
-   case 141:
-      play_note('C', 0, 4, 2);
-      break;
-   case 142:
-      play_note('D', 0, 4, 4);
-      break;
-   case 143:
-      play_note('E', 0, 4, 2);
-      break;
-   case 144:
-      play_note('C', 0, 4, 2);
-      break;
-   case 145:
-      play_rest(2);
-      break;
-   case 146:
-      play_note('A', 0, 3, 2);
-      break;
-   case 147:
-      play_note('G', 0, 3, 4);
-      break;
-   case 148:
-      play_rest(8);
-      break;
-   default:
-      notes = -1;
-   }
-} //song2
-
-void song3(uint16_t note)
-{ //(Max and Kellen)
-   switch (note)
-   {
-   case 0:
-      play_note('E', 0, 4, 7);
-      break;
-   case 1:
-      play_rest(1);
-      break;
-   case 2:
-      play_note('E', 0, 4, 7);
-      break;
-   case 3:
-      play_rest(1);
-      break;
-   case 4:
-      play_note('E', 0, 4, 7);
-      break;
-   case 5:
-      play_rest(1);
-      break;
-   case 6:
-      play_note('E', 0, 4, 3);
-      break;
-   case 7:
-      play_rest(1);
-      break;
-   case 8:
-      play_note('E', 0, 4, 3);
-      break;
-   case 9:
-      play_rest(5);
-      break;
-   case 10:
-      play_note('E', 0, 5, 4);
-      break;
-   case 11:
-      play_note('G', 1, 5, 4);
-      break;
-   case 12:
-      play_note('E', 0, 5, 4);
-      break;
-   case 13:
-      play_note('G', 0, 5, 8);
-      break;
-   case 14:
-      play_note('E', 0, 5, 8);
-      break;
-      //phrase
-   case 15:
-      play_note('E', 1, 4, 7);
-      break;
-   case 16:
-      play_rest(1);
-      break;
-   case 17:
-      play_note('E', 1, 4, 7);
-      break;
-   case 18:
-      play_rest(1);
-      break;
-   case 19:
-      play_note('E', 1, 4, 7);
-      break;
-   case 20:
-      play_rest(1);
-      break;
-   case 21:
-      play_note('E', 1, 4, 3);
-      break;
-   case 22:
-      play_rest(1);
-      break;
-   case 23:
-      play_note('E', 1, 4, 3);
-      break;
-   case 24:
-      play_rest(5);
-      break;
-   case 25:
-      play_note('E', 1, 5, 4);
-      break;
-   case 26:
-      play_note('E', 0, 5, 3);
-      break;
-   case 27:
-      play_rest(1); //rest 1
-      break;
-   case 28:
-      play_note('E', 0, 5, 4);
-      break;
-   case 29:
-      play_note('G', 1, 5, 8);
-      break;
-   case 30:
-      play_note('E', 0, 5, 8);
-      break;
-   default:
-      notes = -1;
-   }
-} //song3
-
-void play_song(uint8_t song, uint8_t note)
-{
-   //if you add a song, you'll have to add it to this
-   //switch statement.
-   switch (song)
-   {
-   case 0:
-      song0(note); //beaver fight song
-      break;
-   case 1:
-      song1(note); //tetris theme
-      break;
-   case 2:
-      song2(note); //super mario bros
-      break;
-   case 3:
-      song3(note);
-      break;
-   default:
-      song0(note); //defaults to beaver fight song
-   }
-}
-
-void play_rest(uint8_t duration)
-{
-   //mute for duration
-   //duration is in 64th notes at 120bpm
-   //PORTD |= mute;
-   PORTD |= (0 << PD7);
-   beat = 0;
-   max_beat = duration;
-   rest_flag = 1;
-}
-
-void play_rest2(uint8_t duration)
-{
-   //mute for duration
-   //duration is in 64th notes at 120bpm
-   //PORTD |= mute;
-   PORTD |= (0 << PD6);
-   beat2 = 0;
-   max_beat2 = duration;
-   rest_flag2 = 1;
-}
-
-void write_bargraph(uint8_t notes_to_play)
-{
-   //write the signal strength of the radio to the bargraph
-   PORTD &= ~(1 << PD2); //enable bar graph display, PORTB, bit 7
-   SPDR = notes_to_play; //send to display
-   while (bit_is_clear(SPSR, SPIF))
-   {
-   }               //wait till data sent out (while loop)
-   PORTB |= 0x01;  //HC595 output reg - rising edge...
-   PORTB &= ~0x01; //and falling edge
-   PORTD |= (1 << PD2);
-}
-
-unsigned int reverseBits(unsigned int num)
-{
-   unsigned int NO_OF_BITS = 8;
-   unsigned int reverse_num = 0, i, temp;
-
-   for (i = 0; i < NO_OF_BITS; i++)
-   {
-      temp = (num & (1 << i));
-      if (temp)
-         reverse_num |= (1 << ((NO_OF_BITS - 1) - i));
-   }
-
-   return reverse_num;
-}
-
-void arpeggiateDown(uint8_t note, uint8_t notes_to_play, uint8_t duration, uint8_t octave, uint8_t step)
-{
-   volatile char *key = mode1_d;
-   uint8_t i, j;
-   static uint8_t run = 2;
-   static uint8_t rest_flag_arp = 0;
-
-   //mirror the notes to play
-   notes_to_play = reverseBits(notes_to_play);
-
-   if ((type1 == 3 || type1 == 4) && (run == 1))
-      chop_bot1 = 1;
-
-   if (notes_to_play == 0)
-   {
-      run = step;
-      notes = -1;
-      chop_top1 = 0;
-      chop_bot1 = 0;
-
-      if (type1 == 3)
-         p_flag1 = 1;
-      else if (type1 == 4)
-         p_flag1 = 0;
+      if (st->notes == 7)
+      {
+         if ((_BV(j) & notes_to_play) && (j == 7) && (octave + st->run_down) != 8)
+         {                                                            //verify that we are not trying to play on the 9th octave (Crash)
+            seq_key(s, 0, octave + st->run_down); //run has already been incremented at this point
+            seq_bar(1);
+         }
+         st->notes = -1;
+         st->run_down--;
+         if ((st->run_down < step) && ((_BV(0) & notes_to_play) && (_BV(7) & notes_to_play)))
+            st->octave_down = 1;
 
-      play_rest(1);
-      if (switch_ch == 1)
-         write_bargraph(notes_to_play);
-   }
-   else
-   {
-      for (i = run; i >= 0; i--)
+         if (st->run_down == 0)
+         {
+            st->octave_down = 0;
+            st->run_down = step;
+            st->p_flag = 1;
+         }
+      }
+      //edge case for handling single note input on single step
+      if ((_BV(j) & notes_to_play) && (notes_to_play == 1 || notes_to_play == 2 || notes_to_play == 4 || notes_to_play == 8 || notes_to_play == 16 || notes_to_play == 32 || notes_to_play == 64 || notes_to_play == 128) && (step == 1))
       {
-         for (j = notes; j < 8; j++)
+         if (st->rest_down == 0)
          {
-            if (notes == 7)
-            {
-               if ((_BV(j) & notes_to_play) && (j == 7) && (octave + run) != 8)
-               {                                                //verify that we are not trying to play on the 9th octave (Crash)
-                  play_note(key[j], 0, octave + run, duration); //run has already been incremented at this point
-                  if (switch_ch == 1)
-                     write_bargraph(1);
-               }
-               notes = -1;
-               run--;
-               if ((run < step) && ((_BV(0) & notes_to_play) && (_BV(7) & notes_to_play)))
-                  octave_flag_down1 = 1;
-
-               if (run == 0)
-               {
-                  octave_flag_down1 = 0;
-                  p_flag1 = 1;
-                  run = step;
-               }
+            if ((_BV(j) & notes_to_play) && (j == 7) && (octave + st->run_down) != 8)
+            { //play thr octave at intervals
+               seq_key(s, 0, octave + st->run_down);
             }
-            //edge case for handling single note input on single step
-            if ((_BV(j) & notes_to_play) && (notes_to_play == 1 || notes_to_play == 2 || notes_to_play == 4 || notes_to_play == 8 || notes_to_play == 16 || notes_to_play == 32 || notes_to_play == 64 || notes_to_play == 128) && (step == 1))
+            else
             {
-               if (rest_flag_arp == 0)
-               {
-                  if ((_BV(j) & notes_to_play) && (j == 7) && (octave + run) != 8)
-                  { //play thr octave at intervals
-                     play_note(key[j], 0, octave + run, duration);
-                  }
-                  else
-                  {
-                     play_note(key[j], 0, octave, duration); //play all other notes at intervals
-                  }
-                  rest_flag_arp = 1;
-                  if (switch_ch == 1)
-                     write_bargraph(_BV((j * -1) + 7));
-               }
-               else
-               {
-                  rest_flag_arp = 0;
-                  play_rest(duration);
-                  if (switch_ch == 1)
-                     write_bargraph(0);
-                  break;
-               }
-            }
-            if ((_BV(j) & notes_to_play) && (j == 7))
-            {
-               //play_note(key[j], 0, octave+run, duration);   //run has already been incremented at this point
-               //notes = j;
-               //play_rest(duration);
-               break;
-            }
-            if ((_BV(j) & notes_to_play) && (j <= modal1))
-            { //if the given note is set, edit stuffs here
-                  play_note(key[j], 0, octave + run + 1, duration);
-               notes = j;
-               if (switch_ch == 1)
-                  write_bargraph(_BV((j * -1) + 7));
-               break;
-            }
-            if (_BV(j) & notes_to_play)
-            { //if the given note is set
-               if (j == 0)
-                  play_note(key[j], 0, octave + run + 1, duration);
-               else
-                  play_note(key[j], 0, octave + run, duration);
-               notes = j;
-               if (switch_ch == 1)
-                  write_bargraph(_BV((j * -1) + 7));
-               break;
+               seq_key(s, 7 - j, octave); //play all other notes at intervals
             }
+            st->rest_down = 1;
+            seq_bar(_BV((j * -1) + 7));
          }
+         else
+         {
+            st->rest_down = 0;
+            seq_rest();
+            seq_bar(0);
+            break;
+         }
+      }
+      if ((_BV(j) & notes_to_play) && (j == 7))
+         break;
+      if (_BV(j) & notes_to_play)
+      { //if the given note is set, the keys are mirrored
+         seq_key(s, 7 - j, octave + st->run_down);
+         st->notes = j;
+         seq_bar(_BV((j * -1) + 7));
          break;
       }
    }
@@ -1433,1919 +441,1060 @@ void arpeggiateDown(uint8_t note, uint8_t notes_to_play, uint8_t duration, uint8
 
 //edge case we want up down for single note across octaves
 //notes: notes is the incremental count that holds which note we need to play
-void arpeggiate(uint8_t note, uint8_t notes_to_play, uint8_t duration, uint8_t octave, uint8_t step)
+static void arpeggiate(const arp_seq_t *s, arp_state_t *st, uint8_t notes_to_play, uint8_t octave)
 {
-   volatile char *key = mode1;
-   uint8_t i, j;
-   static uint8_t run = 0;
-   static uint8_t rest_flag_arp = 0;
+   uint8_t step = s->steps;
+   uint8_t j;
 
-   if ((type1 == 3 || type1 == 4) && (run == (step - 1)))
-      chop_top1 = 1;
+   if ((s->type == 3 || s->type == 4) && (st->run_up == (step - 1)))
+      st->chop_top = 1;
 
    if (notes_to_play == 0)
    {
-      run = 0;
-      notes = -1;
+      st->run_up = 0;
+      st->notes = -1;
 
-      octave_flag_up1 = 0;
+      st->octave_up = 0;
 
-      chop_top1 = 0;
-      chop_bot1 = 0;
+      st->chop_top = 0;
+      st->chop_bot = 0;
 
-      if (type1 == 3)
-         p_flag1 = 1;
-      else if (type1 == 4)
-         p_flag1 = 0;
+      if (s->type == 3)
+         st->p_flag = 1;
+      else if (s->type == 4)
+         st->p_flag = 0;
 
-      play_rest(1);
-      if (switch_ch == 1)
-         write_bargraph(notes_to_play);
+      seq_idle();
+      seq_bar(notes_to_play);
+      return;
    }
-   else
+
+   for (j = st->notes; j < 8; j++)
    {
-      for (i = run; i < step; i++)
+      if (st->notes == 7)
       {
-         for (j = notes; j < 8; j++)
+         if ((_BV(j) & notes_to_play) && (j == 7) && (octave + st->run_up) != 8)
+         {                                                              //verify that we are not trying to play on the 9th octave (Crash)
+            seq_key(s, 7, octave + st->run_up); //run has already been incremented at this point
+            seq_bar(_BV(j));
+         }
+         st->notes = -1;
+         st->run_up++;
+         if ((st->run_up > 0) && ((_BV(0) & notes_to_play) && (_BV(7) & notes_to_play)))
+            st->octave_up = 1;
+         if (st->run_up == step)
+         { //set a flag right here for going onto the next bar in the sequence
+            st->octave_up = 0;
+            st->run_up = 0;
+            st->p_flag = 0;
+         }
+      }
+      //edge case for handling single note input on single step
+      if ((_BV(j) & notes_to_play) && (notes_to_play == 1 || notes_to_play == 2 || notes_to_play == 4 || notes_to_play == 8 || notes_to_play == 16 || notes_to_play == 32 || notes_to_play == 64 || notes_to_play == 128) && (step == 1))
+      {
+         if (st->rest_up == 0)
          {
-            if (notes == 7)
-            {
-               if ((_BV(j) & notes_to_play) && (j == 7) && (octave + run) != 8)
-               {                                                    //verify that we are not trying to play on the 9th octave (Crash)
-                  play_note(key[j], 0, octave + run + 1, duration); //run has already been incremented at this point
-                  if (switch_ch == 1)
-                     write_bargraph(_BV(j));
-               }
-               notes = -1;
-               run++;
-               if ((run > 0) && ((_BV(0) & notes_to_play) && (_BV(7) & notes_to_play)))
-                  octave_flag_up1 = 1;
-               if (run == step)
-               {
-                  octave_flag_up1 = 0;
-                  p_flag1 = 0;
-                  run = 0;
-               }
+            if ((_BV(j) & notes_to_play) && (j == 7) && (octave + st->run_up) != 8)
+            { //play thr octave at intervals
+               seq_key(s, 7, octave + st->run_up);
             }
-            //edge case for handling single note input on single step
-            if ((_BV(j) & notes_to_play) && (notes_to_play == 1 || notes_to_play == 2 || notes_to_play == 4 || notes_to_play == 8 || notes_to_play == 16 || notes_to_play == 32 || notes_to_play == 64 || notes_to_play == 128) && (step == 1))
+            else
             {
-               if (rest_flag_arp == 0)
-               {
-                  if ((_BV(j) & notes_to_play) && (j == 7) && (octave + run) != 8)
-                  { //play thr octave at intervals
-                     play_note(key[j], 0, octave + run + 1, duration);
-                  }
-                  else
-                  {
-                     play_note(key[j], 0, octave, duration); //play all other notes at intervals
-                  }
-                  rest_flag_arp = 1;
-                  if (switch_ch == 1)
-                     write_bargraph(_BV(j));
-               }
-               else
-               {
-                  rest_flag_arp = 0;
-                  play_rest(duration);
-                  if (switch_ch == 1)
-                     write_bargraph(0);
-                  break;
-               }
-            }
-            if ((_BV(j) & notes_to_play) && (j == 7))
-            {
-               //play_note(key[j], 0, octave+run, duration);	//run has already been incremented at this point
-               //notes = j;
-               //play_rest(duration);
-               break;
-            }
-            if ((_BV(j) & notes_to_play) && (j >= 7 - modal1))
-            { //if the given note is set, edit stuffs here
-               play_note(key[j], 0, octave + run + 1, duration);
-               notes = j;
-               if (switch_ch == 1)
-                  write_bargraph(_BV(j));
-               break;
-            }
-            if (_BV(j) & notes_to_play)
-            { //if the given note is set, edit stuffs here
-               play_note(key[j], 0, octave + run, duration);
-               notes = j;
-               if (switch_ch == 1)
-                  write_bargraph(_BV(j));
-               break;
+               seq_key(s, j, octave); //play all other notes at intervals
             }
+            st->rest_up = 1;
+            seq_bar(_BV(j));
          }
+         else
+         {
+            st->rest_up = 0;
+            seq_rest();
+            seq_bar(0);
+            break;
+         }
+      }
+      if ((_BV(j) & notes_to_play) && (j == 7))
+         break;
+      if (_BV(j) & notes_to_play)
+      { //if the given note is set
+         seq_key(s, j, octave + st->run_up);
+         st->notes = j;
+         seq_bar(_BV(j));
          break;
       }
    }
 }
 
-void arpeggiateDown2(uint8_t note, uint8_t notes_to_play, uint8_t duration, uint8_t octave, uint8_t step)
-{
-   volatile char *key = mode2_d;
-   uint8_t i, j;
-   static uint8_t run = 2;
-   static uint8_t rest_flag_arp = 0;
-
-   //mirror the notes to play
-   notes_to_play = reverseBits(notes_to_play);
+//semitone offset of the natural notes 'A' - 'G' from C
+static const uint8_t letter_offset[7] = {9, 11, 0, 2, 4, 5, 7};
 
-   if ((type2 == 3 || type2 == 4) && (run == 1))
-      chop_bot2 = 1;
+uint8_t note_index(char note, uint8_t flat, uint8_t octave)
+{
+   //converts a note name into its semitone number, C0 = 0
+   //flat is ignored on C and F, the same as the old switch tree did
+   //anything past octave 8 returns NUM_NOTES which plays as a rest
+   uint8_t n;
+
+   if (octave > 8 || note < 'A' || note > 'G')
+      return NUM_NOTES;
+   n = octave * 12 + letter_offset[note - 'A'];
+   if (flat && note != 'C' && note != 'F')
+      n--;
+   return n;
+}
 
-   if (notes_to_play == 0)
+void play_semitone(uint8_t channel, uint8_t n, uint8_t duration)
+{
+   //n is the semitone number, 0 (C0) to 107 (B8)
+   //duration is in 64th notes, beats of music_tempo()
+   //the pitch comes from the current tuning, one table load whatever the
+   //note, anything past B8 is a rest
+   //channel is 1 based, channels past 2 only exist in TONE_DDS builds
+   arp_channel_t *c = &arp[channel - 1];
+
+   if (n >= NUM_NOTES)
    {
-      run = step;
-      notes2 = -1;
-
-      octave_flag_down1 = 0;
-
-      chop_top2 = 0;
-      chop_bot2 = 0;
-
-      if (type2 == 3)
-         p_flag2 = 1;
-      else if (type2 == 4)
-         p_flag2 = 0;
-
-      play_rest2(1);
-      if (switch_ch == 2)
-         write_bargraph(notes_to_play);
+      play_rest_on(channel, duration);
+      return;
+   }
+   c->beat = 0;            //reset the beat counter
+   c->max_beat = duration; //set the max beat
+#ifdef TONE_DDS
+   synth_play(channel - 1, n, c->wave, c->accent);
+#else
+   uint16_t count = pgm_read_word(&tuning[n].count);
+   uint8_t cs = pgm_read_byte(&tuning[n].cs);
+
+   //a counter already past the new top would run on to 0xFFFF first.
+   //The clock select only changes while the timer runs, music_off()
+   //stops Timer1 by clearing it
+   if (channel == 1)
+   {
+      OCR1A = count;
+      if (TCNT1 > count)
+         TCNT1 = 0;
+      if (TCCR1B & TONE_CS)
+         TCCR1B = (TCCR1B & ~TONE_CS) | cs;
    }
    else
    {
-      for (i = run; i >= 0; i--)
-      {
-         for (j = notes2; j < 8; j++)
-         {
-            if (notes2 == 7)
-            {
-               if ((_BV(j) & notes_to_play) && (j == 7) && (octave + run) != 8)
-               {                                                 //verify that we are not trying to play on the 9th octave (Crash)
-                  play_note2(key[j], 0, octave + run, duration); //run has already been incremented at this point
-                  if (switch_ch == 2)
-                     write_bargraph(1);
-               }
-               notes2 = -1;
-               run--;
-               if ((run < step) && ((_BV(0) & notes_to_play) && (_BV(7) & notes_to_play)))
-                  octave_flag_down2 = 1;
-
-               if (run == 0)
-               {
-                  octave_flag_down2 = 0;
-                  run = step;
-                  p_flag2 = 1;
-                  if (type2 == 2 || type2 == 3)
-                     sequence_flag = 1;
-               }
-            }
-            //edge case for handling single note input on single step
-            if ((_BV(j) & notes_to_play) && (notes_to_play == 1 || notes_to_play == 2 || notes_to_play == 4 || notes_to_play == 8 || notes_to_play == 16 || notes_to_play == 32 || notes_to_play == 64 || notes_to_play == 128) && (step == 1))
-            {
-               if (rest_flag_arp == 0)
-               {
-                  if ((_BV(j) & notes_to_play) && (j == 7) && (octave + run) != 8)
-                  { //play thr octave at intervals
-                     play_note2(key[j], 0, octave + run, duration);
-                  }
-                  else
-                  {
-                     play_note2(key[j], 0, octave, duration); //play all other notes at intervals
-                  }
-                  rest_flag_arp = 1;
-                  if (switch_ch == 2)
-                     write_bargraph(_BV((j * -1) + 7));
-               }
-               else
-               {
-                  rest_flag_arp = 0;
-                  play_rest2(duration);
-                  if (switch_ch == 2)
-                     write_bargraph(0);
-                  break;
-               }
-            }
-            if ((_BV(j) & notes_to_play) && (j == 7))
-            {
-               if (notes_to_play == 128 && steps2 == 1)
-                  sequence_flag = 1;
-               //play_note(key[j], 0, octave+run, duration);   //run has already been incremented at this point
-               //notes = j;
-               //play_rest(duration);
-               break;
-            }
-            if ((_BV(j) & notes_to_play) && (j <= modal2))
-            { //if the given note is set, edit stuffs here
-               play_note2(key[j], 0, octave + run + 1, duration);
-               notes2 = j;
-               if (switch_ch == 2)
-                  write_bargraph(_BV((j * -1) + 7));
-               break;
-            }
-            if (_BV(j) & notes_to_play)
-            { //if the given note is set
-               if (j == 0)
-                  play_note2(key[j], 0, octave + run + 1, duration);
-               else
-                  play_note2(key[j], 0, octave + run, duration);
-               notes2 = j;
-               if (switch_ch == 2)
-                  write_bargraph(_BV((j * -1) + 7));
-               break;
-            }
-         }
+      OCR3A = count;
+      if (TCNT3 > count)
+         TCNT3 = 0;
+      if (TCCR3B & TONE_CS)
+         TCCR3B = (TCCR3B & ~TONE_CS) | cs;
+   }
+#endif
+}
+
+void play_note(char note, uint8_t flat, uint8_t octave, uint8_t duration)
+{
+   //pass in the note, it's key, the octave they want, and a duration
+
+   //function sets the value of OCR1A and the timer
+   //note must be A-G
+   //flat must be 1 (for flat) or 0 (for natural) (N/A on C or F)
+   //octave must be 0-8 (0 is the lowest, 8 doesn't sound very good)
+   //duration is in 64th notes, beats of music_tempo()
+   //e.g. play_note('D', 1, 0, 16)
+   //this would play a Db, octave 0 for 1 quarter note
+   //60 BPM by default (a beat every 62.5ms)
+   play_semitone(1, note_index(note, flat, octave), duration);
+}
+
+void play_note2(char note, uint8_t flat, uint8_t octave, uint8_t duration)
+{
+   //same as play_note but drives channel 2 (OCR3A)
+   play_semitone(2, note_index(note, flat, octave), duration);
+}
+
+//consider doing an upward run, clearing the lowest notes from notes to play and the highest, then switching to a downward run... That should honestly work just fine
+//THIS IS FIRE!
+
+void music_off(void)
+{
+   //this turns the alarm timer off
+   notes = 0;
+#ifndef TONE_DDS
+   TCCR1B &= ~TONE_CS;
+#endif
+   //and mutes the output
+   PORTD |= mute;
+}
+
+void music_on(void)
+{
+   //this starts the alarm timer running
+   uint8_t ch;
+
+   notes = 0;
+#ifndef TONE_DDS
+   //clk/64 until the first note sets each timer's own clock select
+   if (!(TCCR1B & TONE_CS))
+      TCCR1B |= (1 << CS11) | (1 << CS10);
+   if (!(TCCR3B & TONE_CS))
+      TCCR3B |= (1 << CS31) | (1 << CS30);
+#endif
+   //start every arpeggio over on the next music_update()
+   for (ch = 0; ch < ARP_CHANNELS; ch++)
+      seq[ch].valid = 0;
+}
+
+void music_init(void)
+{
+   //initially turned off (use music_on() to turn on)
+
+   //everything from power on, a host build runs this more than once
+   memset(arp, 0, sizeof(arp));
+   memset(seq, 0, sizeof(seq));
+   memset(song_player, 0, sizeof(song_player));
+   scale_user = 0xAB5;
+   pattern_on = 0;
+   pattern_keys = 0;
+   pattern_shift = 0;
+   clock_inc = CLOCK_INC(TEMPO_DEFAULT);
+   tempo = TEMPO_DEFAULT;
+   clock_phase = 0;
+#ifdef NOTE_TRACE
+   trace_beat = 0;
+#endif
+   save1 = 0;
+   delete1 = 0;
+   notes = 0;
+
+   music_tuning(0);
+   pattern_init();
+
+#ifdef TONE_DDS
+   //Timer1 becomes the sample clock and Timer3 the PWM DAC
+   synth_init();
+#else
+#ifdef TONE_HW
+   //OC1C toggles once per CTC period when OCR1C sits at BOTTOM
+   TCCR1A = (1 << COM1C0); //toggle OC1C (PORTB bit 7) on compare
+   OCR1C = 0x0000;
+#else
+   TIMSK |= (1 << OCIE1A); //enable timer interrupt 1 on compare
+   TCCR1A = 0x00;          //TCNT1, normal port operation
+#endif
+   TCCR1B |= (1 << WGM12); //CTC, OCR1A = top, clk/64 (250kHz)
+   TCCR1C = 0x00;          //no forced compare
+   OCR1A = 0x0031;         //(use to vary alarm frequency)
+
+   //initialize second timer
+#ifdef TONE_HW
+   TCCR3A = (1 << COM3A0); //toggle OC3A (PORTE bit 3) on compare
+#else
+   ETIMSK |= (1 << OCIE3A); //enable timer interrupt 1 on compare
+   TCCR3A = 0x00;           //TCNT1, normal port operation
+#endif
+   TCCR3B |= (1 << WGM32);  //CTC, OCR1A = top, clk/64 (250kHz)
+   TCCR3C = 0x00;           //no forced compare
+   OCR3A = 0x0046;          //(use to vary alarm frequency)
+#endif
+
+   music_on();
+}
+
+//this function will chop out the highest and lowest note in the sequence of notes to play
+//kinda shitty way to do this
+uint8_t process_notes_top(uint8_t n)
+{
+   uint8_t new = n;
+   int i;
+   for (i = 7; i >= 0; i--)
+   {
+      if (n & (1 << i))
+      { //if the bit is set
+         new &= ~(1 << i);
          break;
       }
    }
+   return new;
 }
 
-void arpeggiate2(uint8_t note, uint8_t notes_to_play, uint8_t duration, uint8_t octave, uint8_t step)
+uint8_t process_notes_bot(uint8_t n)
 {
-   volatile char *key = mode2;
-   uint8_t i, j;
-   static uint8_t run = 0;
-   static uint8_t rest_flag_arp = 0;
-
-   if ((type2 == 3 || type2 == 4) && (run == (step - 1)))
-      chop_top2 = 1;
+   uint8_t new = n;
+   int i;
+   for (i = 0; i < 8; i++)
+   {
+      if (n & (1 << i))
+      { //if the bit is set
+         new &= ~(1 << i);
+         break;
+      }
+   }
+   return new;
+}
 
-   if (notes_to_play == 0)
+uint8_t check_notes(uint8_t n)
+{
+   uint8_t count = 0;
+   int i;
+   for (i = 0; i < 8; i++)
    {
-      run = 0;
-      notes2 = -1;
+      if (n & (1 << i))
+      {
+         count++;
+      }
+   }
+   if (count == 2)
+      return 1;
+   return 0;
+}
+
+/*********************************************************************/
+/*                             arp_step                              */
+/*Advances an arpeggio state by one step. Only called while          */
+/*compiling the step buffer, s holds the inputs it is compiled from. */
+/*********************************************************************/
+
+static void arp_step(const arp_seq_t *s, arp_state_t *st)
+{
+   uint8_t n = s->notes_to_play;
 
-      chop_top2 = 0;
-      chop_bot2 = 0;
+   st->notes++; //move on to the next note
+   //wraps from -1 to 0, arpeggiate*() index key[8] from it
+   MUSIC_CHECK(st->notes < 8);
+   MUSIC_CHECK(st->run_up < s->steps && st->run_down <= s->steps);
 
-      if (type2 == 3)
-         p_flag2 = 1;
-      else if (type2 == 4)
-         p_flag2 = 0;
+   if (s->type == 1)
+   {
+      uint8_t new = n;
+      if (st->octave_up == 1)
+      {
+         new = (n & ~(1 << 0));
+      }
+      arpeggiate(s, st, new, s->octave);
+   }
 
-      play_rest2(1);
-      if (switch_ch == 2)
-         write_bargraph(notes_to_play);
+   else if (s->type == 2)
+   {
+      uint8_t new = n;
+      if (st->octave_down == 1)
+      {
+         new = (n & ~(1 << 7));
+      }
+      arpeggiateDown(s, st, new, s->octave);
    }
-   else
+
+   //Arpeggiate up down, chop top and bottom
+   else if (s->type == 3)
    {
-      for (i = run; i < step; i++)
+      if ((check_notes(n) && s->steps == 1) || ((n == 1 || n == 2 || n == 4 || n == 8 || n == 16 || n == 32 || n == 64 || n == 128) && (s->steps == 1))) //if less than three notes just play down
+         arpeggiate(s, st, n, s->octave);
+      else
       {
-         for (j = notes2; j < 8; j++)
+         if (st->p_flag == 1)
+         { //after completing the run turn flag to zero, initialze the flag when changing to this mode, set it to one.
+
+            //must go last
+            uint8_t new = n;
+            if (st->octave_up == 1)
+            {
+               new = (n & ~(1 << 0));
+            }
+
+            arpeggiate(s, st, new, s->octave);
+         }
+         else if (st->p_flag == 0)
          {
-            if (notes2 == 7)
+            uint8_t new = n;
+
+            if (st->chop_bot == 1)
+            {
+               new = process_notes_bot(n);
+               st->chop_bot = 0;
+            }
+            if (st->chop_top == 1)
+            {
+               new = process_notes_top(n);
+               st->chop_top = 0;
+            }
+            if (st->octave_down == 1)
             {
-               if ((_BV(j) & notes_to_play) && (j == 7) && (octave + run) != 8)
-               {                                                     //verify that we are not trying to play on the 9th octave (Crash)
-                  play_note2(key[j], 0, octave + run + 1, duration); //run has already been incremented at this point
-                  if (switch_ch == 2)
-                     write_bargraph(_BV(j));
-               }
-               notes2 = -1;
-               run++;
-               if ((run > 0) && ((_BV(0) & notes_to_play) && (_BV(7) & notes_to_play)))
-                  octave_flag_up2 = 1;
-               if (run == step)
-               { //set a flag right here for going onto the next bar in the sequence
-                  octave_flag_up2 = 0;
-                  run = 0;
-                  p_flag2 = 0;
-                  if (type2 == 1 || type2 == 4)
-                     sequence_flag = 1;
-               }
+               new = (new & ~(1 << 7));
             }
-            //edge case for handling single note input on single step
-            if ((_BV(j) & notes_to_play) && (notes_to_play == 1 || notes_to_play == 2 || notes_to_play == 4 || notes_to_play == 8 || notes_to_play == 16 || notes_to_play == 32 || notes_to_play == 64 || notes_to_play == 128) && (step == 1))
+
+            arpeggiateDown(s, st, new, s->octave - 1);
+         }
+      }
+   }
+
+   //Arpeggiate down up, chop top and bottom
+   else if (s->type == 4)
+   {
+      if ((check_notes(n) && s->steps == 1) || ((n == 1 || n == 2 || n == 4 || n == 8 || n == 16 || n == 32 || n == 64 || n == 128) && (s->steps == 1))) //if less than three notes just play down
+         arpeggiateDown(s, st, n, s->octave - 1);
+      else
+      {
+         if (st->p_flag == 0)
+         { //after completing the run turn flag to zero, initialze the flag when changing to this mode, set it to one.
+            uint8_t new = n;
+            if (st->octave_down == 1)
             {
-               if (rest_flag_arp == 0)
-               {
-                  if ((_BV(j) & notes_to_play) && (j == 7) && (octave + run) != 8)
-                  { //play thr octave at intervals
-                     play_note2(key[j], 0, octave + run + 1, duration);
-                  }
-                  else
-                  {
-                     play_note2(key[j], 0, octave, duration); //play all other notes at intervals
-                  }
-                  rest_flag_arp = 1;
-                  if (switch_ch == 2)
-                     write_bargraph(_BV(j));
-               }
-               else
-               {
-                  rest_flag_arp = 0;
-                  play_rest2(duration);
-                  if (switch_ch == 2)
-                     write_bargraph(0);
-                  break;
-               }
+               new = (n & ~(1 << 7));
             }
-            if ((_BV(j) & notes_to_play) && (j == 7))
+            arpeggiateDown(s, st, new, s->octave - 1);
+         }
+         else if (st->p_flag == 1)
+         {
+            uint8_t new2 = n;
+
+            if (st->chop_top == 1)
             {
-               if (notes_to_play == 128 && steps2 == 1)
-                  sequence_flag = 1;
-               //play_note(key[j], 0, octave+run, duration);   //run has already been incremented at this point
-               //notes = j;
-               //play_rest(duration);
-               break;
+               new2 = process_notes_top(n);
+               st->chop_top = 0;
             }
-            if ((_BV(j) & notes_to_play) && (j >= 7 - modal2))
-            { //if the given note is set, edit stuffs here
-               play_note2(key[j], 0, octave + run + 1, duration);
-               notes2 = j;
-               if (switch_ch == 2)
-                  write_bargraph(_BV(j));
-               break;
+
+            if (st->chop_bot == 1)
+            {
+               new2 = process_notes_bot(n);
+               st->chop_bot = 0;
             }
-            if (_BV(j) & notes_to_play)
-            { //if the given note is set
-               play_note2(key[j], 0, octave + run, duration);
-               notes2 = j;
-               if (switch_ch == 2)
-                  write_bargraph(_BV(j));
-               break;
+            if (st->octave_up == 1)
+            {
+               new2 = (new2 & ~(1 << 0));
             }
+            arpeggiate(s, st, new2, s->octave);
          }
+      }
+   }
+}
+
+static void arp_advance(const arp_seq_t *s, arp_state_t *st)
+{
+   //runs one step from st and leaves what it played in seq_cur
+   seq_cur.note = SEQ_NONE;
+   seq_cur.bar = 0;
+   arp_step(s, st);
+}
+
+/*********************************************************************/
+/*                             seq_compile                           */
+/*Fills s with the steps the arpeggiate functions play from a fresh  */
+/*start (the state they are left in when all keys are let go).       */
+/*The state repeats after a while, Brent's cycle search finds where  */
+/*the repeating part starts (mu) and how long it is (lam) so the     */
+/*buffer holds the lead-in once and the loop once.                   */
+/*********************************************************************/
+
+static void seq_compile(arp_seq_t *s)
+{
+   arp_state_t start, slow, fast;
+   uint16_t power, lam, mu, i;
+   uint8_t len = 0;
+   uint8_t loop = 0;
+
+   memset(&start, 0, sizeof(start));
+   start.notes = 0xFF; //-1, the step function increments it first
+   start.run_down = s->steps;
+   start.p_flag = (s->type == 4) ? 0 : 1;
+
+   //find the period
+   power = 1;
+   lam = 1;
+   slow = start;
+   fast = start;
+   arp_advance(s, &fast);
+   for (i = 0; memcmp(&slow, &fast, sizeof(fast)) != 0; i++)
+   {
+      if (i == SEQ_SEARCH)
          break;
+      if (power == lam)
+      {
+         slow = fast;
+         power <<= 1;
+         lam = 0;
+      }
+      arp_advance(s, &fast);
+      lam++;
+   }
+
+   //find the lead-in, fast runs lam steps ahead of slow
+   mu = 0;
+   if (i < SEQ_SEARCH)
+   {
+      slow = start;
+      fast = start;
+      for (i = 0; i < lam; i++)
+         arp_advance(s, &fast);
+      while (memcmp(&slow, &fast, sizeof(fast)) != 0 && mu < SEQ_SEARCH)
+      {
+         arp_advance(s, &slow);
+         arp_advance(s, &fast);
+         mu++;
+      }
+   }
+   else
+      lam = SEQ_SEARCH; //no cycle found, play as much as fits
+
+   //record the steps that play something
+   slow = start;
+   for (i = 0; i < mu + lam; i++)
+   {
+      if (i == mu)
+         loop = len;
+      arp_advance(s, &slow);
+      if (seq_cur.note != SEQ_NONE)
+      {
+         MUSIC_CHECK(len < SEQ_LEN); //SEQ_LEN is below the longest pattern
+         if (len == SEQ_LEN)
+            break; //keeps the buffer, the arpeggio is cut short
+         s->step[len++] = seq_cur;
       }
    }
+   if (loop >= len)
+      loop = len ? len - 1 : 0;
+
+   s->len = len;
+   s->loop = loop;
 }
 
-void play_note(char note, uint8_t flat, uint8_t octave, uint8_t duration)
+/*********************************************************************/
+/*                             set_control                           */
+/*Steps one control of a channel up (inc = 1) or down, for EV_PARAM. */
+/*octave + steps can be at most 9, the run must not go past octave 8 */
+/*********************************************************************/
+
+static void set_control(arp_channel_t *c, uint8_t attribute, uint8_t inc)
 {
-   //pass in the note, it's key, the octave they want, and a duration
+   uint8_t limit;
 
-   //function sets the value of OCR1A and the timer
-   //note must be A-G
-   //flat must be 1 (for flat) or 0 (for natural) (N/A on C or F)
-   //octave must be 0-8 (0 is the lowest, 8 doesn't sound very good)
-   //duration is in 64th notes at 120bpm
-   //e.g. play_note('D', 1, 0, 16)
-   //this would play a Db, octave 0 for 1 quarter note
-   //120 bpm (every 32ms inc beat)
-   //PORTD &= unmute;      //unmute (just in case)
-   //PORTD = (1 << PC0);
-   beat = 0;            //reset the beat counter
-   max_beat = duration; //set the max beat
-   switch (octave)
+   switch (attribute)
    {
-   case 0:
-      switch (note)
+   case 0: //root
+      if (inc)
       {
-      case 'A':
-         if (flat)
-         {
-            OCR1A = Ab0;
-         }
-         else
-         {
-            OCR1A = A0;
-         }
-         break;
-      case 'B':
-         if (flat)
-         {
-            OCR1A = Bb0;
-         }
-         else
-         {
-            OCR1A = B0;
-         }
-         break;
-      case 'C':
-         OCR1A = C0;
-         break;
-      case 'D':
-         if (flat)
-         {
-            OCR1A = Db0;
-         }
-         else
-         {
-            OCR1A = D0;
-         }
-         break;
-      case 'E':
-         if (flat)
-         {
-            OCR1A = Eb0;
-         }
-         else
-         {
-            OCR1A = E0;
-         }
-         break;
-      case 'F':
-         OCR1A = F0;
-         break;
-      case 'G':
-         if (flat)
-         {
-            OCR1A = Gb0;
-         }
-         else
-         {
-            OCR1A = G0;
-         }
-         break;
+         if (c->root < 11)
+            c->root++;
       }
-      break;
-   case 1:
-      switch (note)
+      else
       {
-      case 'A':
-         if (flat)
-         {
-            OCR1A = Ab1;
-         }
-         else
-         {
-            OCR1A = A1;
-         }
-         break;
-      case 'B':
-         if (flat)
-         {
-            OCR1A = Bb1;
-         }
-         else
-         {
-            OCR1A = B1;
-         }
-         break;
-      case 'C':
-         OCR1A = C1;
-         break;
-      case 'D':
-         if (flat)
-         {
-            OCR1A = Db1;
-         }
-         else
-         {
-            OCR1A = D1;
-         }
-         break;
-      case 'E':
-         if (flat)
-         {
-            OCR1A = Eb1;
-         }
-         else
-         {
-            OCR1A = E1;
-         }
-         break;
-      case 'F':
-         OCR1A = F1;
-         break;
-      case 'G':
-         if (flat)
-         {
-            OCR1A = Gb1;
-         }
-         else
-         {
-            OCR1A = G1;
-         }
-         break;
+         if (c->root > 0)
+            c->root--;
+      }
+      break;
+   case 1: //steps
+      if (inc)
+      { //octaves can be 0-8, 0 being the lowest!
+         limit = 9 - c->octave;
+         if (c->steps > limit)
+            c->steps = limit;
+         else if (c->steps < limit)
+            c->steps++;
+      }
+      else
+      { //decrement the number of steps
+         if (c->steps > 1)
+            c->steps--;
       }
       break;
-   case 2:
-      switch (note)
+   case 2: //rate
+      if (inc)
       {
-      case 'A':
-         if (flat)
-         {
-            OCR1A = Ab2;
-         }
-         else
-         {
-            OCR1A = A2;
-         }
-         break;
-      case 'B':
-         if (flat)
-         {
-            OCR1A = Bb2;
-         }
-         else
-         {
-            OCR1A = B2;
-         }
-         break;
-      case 'C':
-         OCR1A = C2;
-         break;
-      case 'D':
-         if (flat)
-         {
-            OCR1A = Db2;
-         }
-         else
-         {
-            OCR1A = D2;
-         }
-         break;
-      case 'E':
-         if (flat)
-         {
-            OCR1A = Eb2;
-         }
-         else
-         {
-            OCR1A = E2;
-         }
-         break;
-      case 'F':
-         OCR1A = F2;
-         break;
-      case 'G':
-         if (flat)
-         {
-            OCR1A = Gb2;
-         }
-         else
-         {
-            OCR1A = G2;
-         }
-         break;
-      }
-      break;
-   case 3:
-      switch (note)
-      {
-      case 'A':
-         if (flat)
-         {
-            OCR1A = Ab3;
-         }
-         else
-         {
-            OCR1A = A3;
-         }
-         break;
-      case 'B':
-         if (flat)
-         {
-            OCR1A = Bb3;
-         }
-         else
-         {
-            OCR1A = B3;
-         }
-         break;
-      case 'C':
-         OCR1A = C3;
-         break;
-      case 'D':
-         if (flat)
-         {
-            OCR1A = Db3;
-         }
-         else
-         {
-            OCR1A = D3;
-         }
-         break;
-      case 'E':
-         if (flat)
-         {
-            OCR1A = Eb3;
-         }
-         else
-         {
-            OCR1A = E3;
-         }
-         break;
-      case 'F':
-         OCR1A = F3;
-         break;
-      case 'G':
-         if (flat)
-         {
-            OCR1A = Gb3;
-         }
-         else
-         {
-            OCR1A = G3;
-         }
-         break;
-      }
-      break;
-   case 4:
-      switch (note)
-      {
-      case 'A':
-         if (flat)
-         {
-            OCR1A = Ab4;
-         }
-         else
-         {
-            OCR1A = A4;
-         }
-         break;
-      case 'B':
-         if (flat)
-         {
-            OCR1A = Bb4;
-         }
-         else
-         {
-            OCR1A = B4;
-         }
-         break;
-      case 'C':
-         OCR1A = C4;
-         break;
-      case 'D':
-         if (flat)
-         {
-            OCR1A = Db4;
-         }
-         else
-         {
-            OCR1A = D4;
-         }
-         break;
-      case 'E':
-         if (flat)
-         {
-            OCR1A = Eb4;
-         }
-         else
-         {
-            OCR1A = E4;
-         }
-         break;
-      case 'F':
-         OCR1A = F4;
-         break;
-      case 'G':
-         if (flat)
-         {
-            OCR1A = Gb4;
-         }
-         else
-         {
-            OCR1A = G4;
-         }
-         break;
-      }
-      break;
-   case 5:
-      switch (note)
-      {
-      case 'A':
-         if (flat)
-         {
-            OCR1A = Ab5;
-         }
-         else
-         {
-            OCR1A = A5;
-         }
-         break;
-      case 'B':
-         if (flat)
-         {
-            OCR1A = Bb5;
-         }
-         else
-         {
-            OCR1A = B5;
-         }
-         break;
-      case 'C':
-         OCR1A = C5;
-         break;
-      case 'D':
-         if (flat)
-         {
-            OCR1A = Db5;
-         }
-         else
-         {
-            OCR1A = D5;
-         }
-         break;
-      case 'E':
-         if (flat)
-         {
-            OCR1A = Eb5;
-         }
-         else
-         {
-            OCR1A = E5;
-         }
-         break;
-      case 'F':
-         OCR1A = F5;
-         break;
-      case 'G':
-         if (flat)
-         {
-            OCR1A = Gb5;
-         }
-         else
-         {
-            OCR1A = G5;
-         }
-         break;
-      }
-      break;
-   case 6:
-      switch (note)
-      {
-      case 'A':
-         if (flat)
-         {
-            OCR1A = Ab6;
-         }
-         else
-         {
-            OCR1A = A6;
-         }
-         break;
-      case 'B':
-         if (flat)
-         {
-            OCR1A = Bb6;
-         }
-         else
-         {
-            OCR1A = B6;
-         }
-         break;
-      case 'C':
-         OCR1A = C6;
-         break;
-      case 'D':
-         if (flat)
-         {
-            OCR1A = Db6;
-         }
-         else
-         {
-            OCR1A = D6;
-         }
-         break;
-      case 'E':
-         if (flat)
-         {
-            OCR1A = Eb6;
-         }
-         else
-         {
-            OCR1A = E6;
-         }
-         break;
-      case 'F':
-         OCR1A = F6;
-         break;
-      case 'G':
-         if (flat)
-         {
-            OCR1A = Gb6;
-         }
-         else
-         {
-            OCR1A = G6;
-         }
-         break;
-      }
-      break;
-   case 7:
-      switch (note)
-      {
-      case 'A':
-         if (flat)
-         {
-            OCR1A = Ab7;
-         }
-         else
-         {
-            OCR1A = A7;
-         }
-         break;
-      case 'B':
-         if (flat)
-         {
-            OCR1A = Bb7;
-         }
-         else
-         {
-            OCR1A = B7;
-         }
-         break;
-      case 'C':
-         OCR1A = C7;
-         break;
-      case 'D':
-         if (flat)
-         {
-            OCR1A = Db7;
-         }
-         else
-         {
-            OCR1A = D7;
-         }
-         break;
-      case 'E':
-         if (flat)
-         {
-            OCR1A = Eb7;
-         }
-         else
-         {
-            OCR1A = E7;
-         }
-         break;
-      case 'F':
-         OCR1A = F7;
-         break;
-      case 'G':
-         if (flat)
-         {
-            OCR1A = Gb7;
-         }
-         else
-         {
-            OCR1A = G7;
-         }
-         break;
-      }
-      break;
-   case 8:
-      switch (note)
-      {
-      case 'A':
-         if (flat)
-         {
-            OCR1A = Ab8;
-         }
-         else
-         {
-            OCR1A = A8;
-         }
-         break;
-      case 'B':
-         if (flat)
-         {
-            OCR1A = Bb8;
-         }
-         else
-         {
-            OCR1A = B8;
-         }
-         break;
-      case 'C':
-         OCR1A = C8;
-         break;
-      case 'D':
-         if (flat)
-         {
-            OCR1A = Db8;
-         }
-         else
-         {
-            OCR1A = D8;
-         }
-         break;
-      case 'E':
-         if (flat)
-         {
-            OCR1A = Eb8;
-         }
-         else
-         {
-            OCR1A = E8;
-         }
-         break;
-      case 'F':
-         OCR1A = F8;
-         break;
-      case 'G':
-         if (flat)
-         {
-            OCR1A = Gb8;
-         }
-         else
-         {
-            OCR1A = G8;
-         }
-         break;
-      }
-      break;
-   default:
-      OCR1A = 0x0000;
-   }
-}
-
-void play_note2(char note, uint8_t flat, uint8_t octave, uint8_t duration)
-{
-   //flat must be 1 (for flat) or 0 (for natural) (N/A on C or F)
-   //octave must be 0-8 (0 is the lowest, 8 doesn't sound very good)
-   //duration is in 64th notes at 120bpm
-   //e.g. play_note('D', 1, 0, 16)
-   //this would play a Db, octave 0 for 1 quarter note
-   //120 bpm (every 32ms inc beat)
-   //PORTD &= unmute;      //unmute (just in case)
-   //PORTD = (1 << PC0);
-   beat2 = 0;            //reset the beat counter
-   max_beat2 = duration; //set the max beat
-   switch (octave)
-   {
-   case 0:
-      switch (note)
-      {
-      case 'A':
-         if (flat)
-         {
-            OCR3A = Ab0;
-         }
-         else
-         {
-            OCR3A = A0;
-         }
-         break;
-      case 'B':
-         if (flat)
-         {
-            OCR3A = Bb0;
-         }
-         else
-         {
-            OCR3A = B0;
-         }
-         break;
-      case 'C':
-         OCR3A = C0;
-         break;
-      case 'D':
-         if (flat)
-         {
-            OCR3A = Db0;
-         }
-         else
-         {
-            OCR3A = D0;
-         }
-         break;
-      case 'E':
-         if (flat)
-         {
-            OCR3A = Eb0;
-         }
-         else
-         {
-            OCR3A = E0;
-         }
-         break;
-      case 'F':
-         OCR3A = F0;
-         break;
-      case 'G':
-         if (flat)
-         {
-            OCR3A = Gb0;
-         }
-         else
-         {
-            OCR3A = G0;
-         }
-         break;
-      }
-      break;
-   case 1:
-      switch (note)
-      {
-      case 'A':
-         if (flat)
-         {
-            OCR3A = Ab1;
-         }
-         else
-         {
-            OCR3A = A1;
-         }
-         break;
-      case 'B':
-         if (flat)
-         {
-            OCR3A = Bb1;
-         }
-         else
-         {
-            OCR3A = B1;
-         }
-         break;
-      case 'C':
-         OCR3A = C1;
-         break;
-      case 'D':
-         if (flat)
-         {
-            OCR3A = Db1;
-         }
-         else
-         {
-            OCR3A = D1;
-         }
-         break;
-      case 'E':
-         if (flat)
-         {
-            OCR3A = Eb1;
-         }
-         else
-         {
-            OCR3A = E1;
-         }
-         break;
-      case 'F':
-         OCR3A = F1;
-         break;
-      case 'G':
-         if (flat)
-         {
-            OCR3A = Gb1;
-         }
-         else
-         {
-            OCR3A = G1;
-         }
-         break;
-      }
-      break;
-   case 2:
-      switch (note)
-      {
-      case 'A':
-         if (flat)
-         {
-            OCR3A = Ab2;
-         }
-         else
-         {
-            OCR3A = A2;
-         }
-         break;
-      case 'B':
-         if (flat)
-         {
-            OCR3A = Bb2;
-         }
-         else
-         {
-            OCR3A = B2;
-         }
-         break;
-      case 'C':
-         OCR3A = C2;
-         break;
-      case 'D':
-         if (flat)
-         {
-            OCR3A = Db2;
-         }
-         else
-         {
-            OCR3A = D2;
-         }
-         break;
-      case 'E':
-         if (flat)
-         {
-            OCR3A = Eb2;
-         }
-         else
-         {
-            OCR3A = E2;
-         }
-         break;
-      case 'F':
-         OCR3A = F2;
-         break;
-      case 'G':
-         if (flat)
-         {
-            OCR3A = Gb2;
-         }
-         else
-         {
-            OCR3A = G2;
-         }
-         break;
-      }
-      break;
-   case 3:
-      switch (note)
-      {
-      case 'A':
-         if (flat)
-         {
-            OCR3A = Ab3;
-         }
-         else
-         {
-            OCR3A = A3;
-         }
-         break;
-      case 'B':
-         if (flat)
-         {
-            OCR3A = Bb3;
-         }
-         else
-         {
-            OCR3A = B3;
-         }
-         break;
-      case 'C':
-         OCR3A = C3;
-         break;
-      case 'D':
-         if (flat)
-         {
-            OCR3A = Db3;
-         }
-         else
-         {
-            OCR3A = D3;
-         }
-         break;
-      case 'E':
-         if (flat)
-         {
-            OCR3A = Eb3;
-         }
-         else
-         {
-            OCR3A = E3;
-         }
-         break;
-      case 'F':
-         OCR3A = F3;
-         break;
-      case 'G':
-         if (flat)
-         {
-            OCR3A = Gb3;
-         }
-         else
-         {
-            OCR3A = G3;
-         }
-         break;
-      }
-      break;
-   case 4:
-      switch (note)
-      {
-      case 'A':
-         if (flat)
-         {
-            OCR3A = Ab4;
-         }
-         else
-         {
-            OCR3A = A4;
-         }
-         break;
-      case 'B':
-         if (flat)
-         {
-            OCR3A = Bb4;
-         }
-         else
-         {
-            OCR3A = B4;
-         }
-         break;
-      case 'C':
-         OCR3A = C4;
-         break;
-      case 'D':
-         if (flat)
-         {
-            OCR3A = Db4;
-         }
-         else
-         {
-            OCR3A = D4;
-         }
-         break;
-      case 'E':
-         if (flat)
-         {
-            OCR3A = Eb4;
-         }
-         else
-         {
-            OCR3A = E4;
-         }
-         break;
-      case 'F':
-         OCR3A = F4;
-         break;
-      case 'G':
-         if (flat)
-         {
-            OCR3A = Gb4;
-         }
-         else
-         {
-            OCR3A = G4;
-         }
-         break;
-      }
-      break;
-   case 5:
-      switch (note)
-      {
-      case 'A':
-         if (flat)
-         {
-            OCR3A = Ab5;
-         }
-         else
-         {
-            OCR3A = A5;
-         }
-         break;
-      case 'B':
-         if (flat)
-         {
-            OCR3A = Bb5;
-         }
-         else
-         {
-            OCR3A = B5;
-         }
-         break;
-      case 'C':
-         OCR3A = C5;
-         break;
-      case 'D':
-         if (flat)
-         {
-            OCR3A = Db5;
-         }
-         else
-         {
-            OCR3A = D5;
-         }
-         break;
-      case 'E':
-         if (flat)
-         {
-            OCR3A = Eb5;
-         }
-         else
-         {
-            OCR3A = E5;
-         }
-         break;
-      case 'F':
-         OCR3A = F5;
-         break;
-      case 'G':
-         if (flat)
-         {
-            OCR3A = Gb5;
-         }
-         else
-         {
-            OCR3A = G5;
-         }
-         break;
-      }
-      break;
-   case 6:
-      switch (note)
-      {
-      case 'A':
-         if (flat)
-         {
-            OCR3A = Ab6;
-         }
-         else
-         {
-            OCR3A = A6;
-         }
-         break;
-      case 'B':
-         if (flat)
-         {
-            OCR3A = Bb6;
-         }
-         else
-         {
-            OCR3A = B6;
-         }
-         break;
-      case 'C':
-         OCR3A = C6;
-         break;
-      case 'D':
-         if (flat)
-         {
-            OCR3A = Db6;
-         }
-         else
-         {
-            OCR3A = D6;
-         }
-         break;
-      case 'E':
-         if (flat)
-         {
-            OCR3A = Eb6;
-         }
-         else
-         {
-            OCR3A = E6;
-         }
-         break;
-      case 'F':
-         OCR3A = F6;
-         break;
-      case 'G':
-         if (flat)
-         {
-            OCR3A = Gb6;
-         }
-         else
-         {
-            OCR3A = G6;
-         }
-         break;
-      }
-      break;
-   case 7:
-      switch (note)
-      {
-      case 'A':
-         if (flat)
-         {
-            OCR3A = Ab7;
-         }
-         else
-         {
-            OCR3A = A7;
-         }
-         break;
-      case 'B':
-         if (flat)
-         {
-            OCR3A = Bb7;
-         }
-         else
-         {
-            OCR3A = B7;
-         }
-         break;
-      case 'C':
-         OCR3A = C7;
-         break;
-      case 'D':
-         if (flat)
-         {
-            OCR3A = Db7;
-         }
-         else
-         {
-            OCR3A = D7;
-         }
-         break;
-      case 'E':
-         if (flat)
-         {
-            OCR3A = Eb7;
-         }
-         else
-         {
-            OCR3A = E7;
-         }
-         break;
-      case 'F':
-         OCR3A = F7;
-         break;
-      case 'G':
-         if (flat)
-         {
-            OCR3A = Gb7;
-         }
-         else
-         {
-            OCR3A = G7;
-         }
-         break;
-      }
-      break;
-   case 8:
-      switch (note)
-      {
-      case 'A':
-         if (flat)
-         {
-            OCR3A = Ab8;
-         }
-         else
-         {
-            OCR3A = A8;
-         }
-         break;
-      case 'B':
-         if (flat)
-         {
-            OCR3A = Bb8;
-         }
-         else
-         {
-            OCR3A = B8;
-         }
-         break;
-      case 'C':
-         OCR3A = C8;
-         break;
-      case 'D':
-         if (flat)
-         {
-            OCR3A = Db8;
-         }
-         else
-         {
-            OCR3A = D8;
-         }
-         break;
-      case 'E':
-         if (flat)
-         {
-            OCR3A = Eb8;
-         }
-         else
-         {
-            OCR3A = E8;
-         }
-         break;
-      case 'F':
-         OCR3A = F8;
-         break;
-      case 'G':
-         if (flat)
-         {
-            OCR3A = Gb8;
-         }
-         else
-         {
-            OCR3A = G8;
-         }
-         break;
+         if (c->rate < 9)
+            c->rate++;
+      }
+      else
+      {
+         if (c->rate > 1)
+            c->rate--;
+      }
+      break;
+   case 3: //octave
+      if (inc)
+      {
+         limit = 9 - c->steps;
+         if (c->octave > limit)
+            c->octave = limit;
+         else if (c->octave < limit)
+            c->octave++;
+      }
+      else
+      {
+         if (c->octave > 0)
+            c->octave--;
+      }
+      break;
+   case 4: //arp type
+      if (inc)
+      {
+         if (c->type < 4)
+            c->type++;
+      }
+      else
+      {
+         if (c->type > 1)
+            c->type--;
+      }
+      break;
+   case 5: //scale
+      if (inc)
+      {
+         if (c->scale < NUM_SCALES - 1)
+            c->scale++;
+      }
+      else
+      {
+         if (c->scale > 0)
+            c->scale--;
+      }
+      break;
+   case 6: //pattern step length
+      if (inc)
+      {
+         if (c->step_len < 16)
+            c->step_len++;
+      }
+      else
+      {
+         if (c->step_len > 1)
+            c->step_len--;
+      }
+      break;
+#ifdef TONE_DDS
+   case 7: //wave
+      if (inc)
+      {
+         if (c->wave < NUM_WAVES - 1)
+            c->wave++;
+      }
+      else
+      {
+         if (c->wave > 0)
+            c->wave--;
       }
       break;
-   default:
-      OCR3A = 0x0000;
+#endif
    }
 }
 
-//consider doing an upward run, clearing the lowest notes from notes to play and the highest, then switching to a downward run... That should honestly work just fine
-//THIS IS FIRE!
+/*********************************************************************/
+/*                             scale_resolve                         */
+/*Works out the semitone above C each key of a channel plays, from its*/
+/*scale and root, so a step is one table read in seq_key(). Only runs */
+/*when the scale or root changes.                                    */
+/*********************************************************************/
 
-void music_off(void)
+static void scale_resolve(arp_seq_t *s)
 {
-   //this turns the alarm timer off
-   notes = 0;
-   TCCR1B &= ~((1 << CS11) | (1 << CS10));
-   //and mutes the output
-   PORTD |= mute;
+   uint16_t mask;
+   uint8_t k, n;
+
+   mask = s->scale == SCALE_USER ? scale_user : pgm_read_word(&scale_table[s->scale]);
+   mask |= 1;
+   n = s->root;
+   for (k = 0; k < 8; k++)
+   {
+      while (!(mask & _BV((n - s->root) % 12)))
+         n++;
+      s->key[k] = n++;
+   }
 }
 
-void music_on(void)
+void music_scale_user(uint16_t mask)
 {
-   //this starts the alarm timer running
-   notes = 0;
-   notes2 = 0;
-   TCCR1B |= (1 << CS11) | (1 << CS10);
-   TCCR3B |= (1 << CS31) | (1 << CS30);
-   arpeggiate(notes, notes_to_play1, rate1, octave1, steps1);
-   arpeggiate(notes2, notes_to_play2, rate2, octave2, steps2);
+   //sets the SCALE_USER mask, channels on it pick it up at the next
+   //music_update()
+   uint8_t ch;
+
+   scale_user = mask & 0x0FFF;
+   for (ch = 0; ch < ARP_CHANNELS; ch++)
+      if (seq[ch].scale == SCALE_USER)
+         seq[ch].valid = 0;
 }
 
-void music_init(void)
+void music_tuning(uint8_t t)
 {
-   //initially turned off (use music_on() to turn on)
-   TIMSK |= (1 << OCIE1A); //enable timer interrupt 1 on compare
-   TCCR1A = 0x00;          //TCNT1, normal port operation
-   TCCR1B |= (1 << WGM12); //CTC, OCR1A = top, clk/64 (250kHz)
-   TCCR1C = 0x00;          //no forced compare
-   OCR1A = 0x0031;         //(use to vary alarm frequency)
-
-   //initialize second timer
-   ETIMSK |= (1 << OCIE3A); //enable timer interrupt 1 on compare
-   TCCR3A = 0x00;           //TCNT1, normal port operation
-   TCCR3B |= (1 << WGM32);  //CTC, OCR1A = top, clk/64 (250kHz)
-   TCCR3C = 0x00;           //no forced compare
-   OCR3A = 0x0046;          //(use to vary alarm frequency)
-
-   music_on();
-
-   //CH 1
-   beat = 0;
-   max_beat = 0;
-   notes = 0;
-   rest_flag = 0;
-
-   //CH 2
-   beat2 = 0;
-   max_beat2 = 0;
-   notes2 = 0;
-   rest_flag2 = 0;
+   //selects tuning t of tuning_table (tunings.c), 0 when there is no
+   //such one. Steps hold semitones, so the next note plays in it already
+   if (t >= pgm_read_byte(&num_tunings))
+      t = 0;
+   tuning = (const tuning_entry_t *)pgm_read_ptr(&tuning_table[t]);
 }
 
-//this function will chop out the highest and lowest note in the sequence of notes to play
-//kinda shitty way to do this
-uint8_t process_notes_top1(uint8_t n)
+/*********************************************************************/
+/*                             set_control_to                        */
+/*Sets one control of a channel to n, for EV_SET. It steps there     */
+/*through set_control() so the limits are the same as the encoder's, */
+/*and stops short where a limit is in the way.                       */
+/*********************************************************************/
+
+static void set_control_to(arp_channel_t *c, uint8_t attribute, uint8_t n)
 {
-   uint8_t new = n;
-   int i;
-   for (i = 7; i >= 0; i--)
+   volatile uint8_t *v;
+   uint8_t last;
+
+   switch (attribute)
    {
-      if (n & (1 << i))
-      { //if the bit is set
-         new &= ~(1 << i);
+   case 0: v = &c->root; break;
+   case 1: v = &c->steps; break;
+   case 2: v = &c->rate; break;
+   case 3: v = &c->octave; break;
+   case 4: v = &c->type; break;
+   case 5: v = &c->scale; break;
+   case 6: v = &c->step_len; break;
+#ifdef TONE_DDS
+   case 7: v = &c->wave; break;
+#endif
+   default: return;
+   }
+   while (*v != n)
+   {
+      last = *v;
+      set_control(c, attribute, n > last);
+      if (*v == last)
          break;
-      }
    }
-   return new;
 }
 
-uint8_t process_notes_bot1(uint8_t n)
+/*********************************************************************/
+/*                             music_update                          */
+/*Called from the main loop. Applies the queued control events and   */
+/*the pattern step that started, then recompiles the step buffer of a */
+/*channel when any of its inputs changed, playback restarts from its */
+/*first step. A pattern step with the same keys and octave as the    */
+/*last one only rewinds the buffer.                                  */
+/*********************************************************************/
+
+void music_update(void)
 {
-   uint8_t new = n;
-   int i;
-   for (i = 0; i < 8; i++)
+   uint8_t ch, n, sreg, notes, octave, restart;
+   int8_t shift;
+   pattern_step_t step;
+   event_t ev;
+
+   //main is the only writer of the arp[] controls, the tone side picks
+   //the changes up at its next step
+   while (event_pop(&ev))
    {
-      if (n & (1 << i))
-      { //if the bit is set
-         new &= ~(1 << i);
+      ch = ev.code & EV_CHANNEL;
+      if (ch >= ARP_CHANNELS)
+         continue;
+      switch (ev.code & EV_KIND)
+      {
+      case EV_NOTES:
+         arp[ch].notes_to_play = ev.value;
+         break;
+      case EV_PARAM:
+         for (n = EV_STEPS_OF(ev.value); n; n--)
+            set_control(&arp[ch], ev.value & EV_ATTRIBUTE, ev.value & EV_UP);
+         break;
+      case EV_SET:
+         set_control_to(&arp[ch], EV_SET_ATTRIBUTE(ev.value), EV_SET_N(ev.value));
+         break;
+      case EV_TEMPO: //music_tempo() keeps it in range
+         n = EV_STEPS_OF(ev.value) * 10;
+         music_tempo(ev.value & EV_UP ? tempo + n : tempo - n);
+         break;
+      case EV_SYNC: //every channel starts over at its next step
+         for (ch = 0; ch < ARP_CHANNELS; ch++)
+            seq[ch].valid = 0;
          break;
       }
    }
-   return new;
-}
 
-uint8_t check_notes1(uint8_t n)
-{
-   uint8_t count = 0;
-   int i;
-   for (i = 0; i < 8; i++)
+   //while the pattern runs its steps stand in for the keys held on
+   //SEQUENCER_CH, starting or stopping it starts the channel over
+   restart = 0;
+   if (pattern_on != pattern_running)
    {
-      if (n & (1 << i))
+      pattern_on = pattern_running;
+      pattern_keys = 0;
+      pattern_shift = 0;
+      arp[SEQUENCER_CH - 1].accent = 0;
+      seq[SEQUENCER_CH - 1].valid = 0;
+      restart = 1;
+   }
+   if (pattern_take(&step) && pattern_on)
+   {
+      pattern_keys = step.keys;
+      pattern_shift = PAT_OCTAVE_OF(step.flags);
+      arp[SEQUENCER_CH - 1].accent = step.flags & PAT_ACCENT;
+      restart = 1;
+   }
+
+   for (ch = 0; ch < ARP_CHANNELS; ch++)
+   {
+      arp_channel_t *c = &arp[ch];
+      arp_seq_t *s = &seq[ch];
+
+      notes = c->notes_to_play;
+      octave = c->octave;
+      if (ch == SEQUENCER_CH - 1 && pattern_on)
+      { //the offset stays inside the octaves set_control() allows
+         notes = pattern_keys;
+         shift = octave + pattern_shift;
+         octave = shift < 0 ? 0 : shift > 9 - c->steps ? 9 - c->steps : shift;
+      }
+
+      if (s->valid && s->notes_to_play == notes && s->steps == c->steps && s->octave == octave && s->type == c->type && s->scale == c->scale && s->root == c->root)
       {
-         count++;
+         if (ch == SEQUENCER_CH - 1 && restart)
+         { //the same arpeggio again from its first step
+            sreg = SREG;
+            cli();
+            s->pos = 0;
+            s->busy = pattern_due;
+            c->max_beat = 0;
+            SREG = sreg;
+         }
+         continue;
+      }
+
+      s->notes_to_play = notes;
+      s->steps = c->steps;
+      s->octave = octave;
+      s->type = c->type;
+      if (!s->valid || s->scale != c->scale || s->root != c->root)
+      {
+         s->scale = c->scale;
+         s->root = c->root;
+         scale_resolve(s);
       }
+
+      //the tone ISR holds its current note while busy is set
+      sreg = SREG;
+      cli();
+      s->busy = 1;
+      SREG = sreg;
+
+      seq_compile(s);
+
+      //a pattern step that started meanwhile keeps the channel held, and
+      //the step this one replaces is cut short
+      sreg = SREG;
+      cli();
+      s->pos = 0;
+      s->busy = ch == SEQUENCER_CH - 1 && pattern_due;
+      if (ch == SEQUENCER_CH - 1 && restart)
+         c->max_beat = 0;
+      SREG = sreg;
+      s->valid = 1;
    }
-   if (count == 2)
-      return 1;
-   return 0;
 }
 
-//this function will chop out the highest and lowest note in the sequence of notes to play
-//kinda shitty way to do this
-uint8_t process_notes_top2(uint8_t n)
+/*********************************************************************/
+/*                             music_pending                         */
+/*Cheap check for the main loop, nonzero when music_update() has     */
+/*something to do. Only events, the pattern and music_on() change    */
+/*what the step buffers are compiled from once main is running.      */
+/*********************************************************************/
+
+uint8_t music_pending(void)
 {
-   uint8_t new = n;
-   int i;
-   for (i = 7; i >= 0; i--)
+   uint8_t ch;
+
+   if (event_pending() || pattern_due || pattern_on != pattern_running)
+      return 1;
+   for (ch = 0; ch < ARP_CHANNELS; ch++)
    {
-      if (n & (1 << i))
-      { //if the bit is set
-         new &= ~(1 << i);
-         break;
-      }
+      if (!seq[ch].valid)
+         return 1;
    }
-   return new;
+   return 0;
 }
 
-uint8_t process_notes_bot2(uint8_t n)
+/*********************************************************************/
+/*                             next_step                             */
+/*Moves channel ch (0 based) on to its next buffered step once the   */
+/*current one has played long enough                                 */
+/*********************************************************************/
+
+#ifdef NOTE_TRACE
+static void trace_step(uint8_t ch, uint8_t note, uint8_t duration)
 {
-   uint8_t new = n;
-   int i;
-   for (i = 0; i < 8; i++)
-   {
-      if (n & (1 << i))
-      { //if the bit is set
-         new &= ~(1 << i);
-         break;
-      }
-   }
-   return new;
+   note_event_t e;
+
+   e.beat = trace_beat;
+   e.channel = ch;
+   e.flags = note == SEQ_REST ? NOTE_REST : note == SEQ_IDLE ? NOTE_IDLE : 0;
+   e.note = e.flags ? 0 : note; //a bad index is left for the reader to see
+   e.duration = duration;
+   note_trace(&e);
 }
+#endif
 
-uint8_t check_notes2(uint8_t n)
+static void next_step(uint8_t ch)
 {
-   uint8_t count = 0;
-   int i;
-   for (i = 0; i < 8; i++)
+   arp_channel_t *c = &arp[ch];
+   arp_seq_t *s = &seq[ch];
+   uint8_t duration = c->rate;
+   seq_step_t st;
+
+   if (s->busy)
+   { //hold whatever is sounding until music_update() is done
+      c->beat = 0;
+      return;
+   }
+
+   if (s->len == 0)
    {
-      if (n & (1 << i))
-      {
-         count++;
-      }
+      st.note = SEQ_IDLE;
+      st.bar = 0;
    }
-   if (count == 2)
-      return 1;
-   return 0;
+   else
+   {
+      MUSIC_CHECK(s->pos < s->len);
+      st = s->step[s->pos];
+      if (++s->pos >= s->len)
+         s->pos = s->loop;
+   }
+
+   c->rest_flag = 0;
+   if (st.note == SEQ_REST || st.note == SEQ_IDLE)
+   {
+      if (st.note == SEQ_IDLE)
+         duration = 1;
+      play_rest_on(ch + 1, duration);
+   }
+   else
+      play_semitone(ch + 1, st.note, duration);
+#ifdef NOTE_TRACE
+   trace_step(ch, st.note, duration);
+#endif
+
+   if (switch_ch == ch + 1)
+      write_bargraph(st.bar);
 }
 
+#ifdef TONE_ISR
 /*********************************************************************/
 /*                             TIMER1_COMPA                          */
-/*Oscillates pin7, PORTD for alarm tone output                       */
+/*Oscillates pin7, PORTD for the channel 1 tone output               */
 /*********************************************************************/
 
 ISR(TIMER1_COMPA_vect)
 {
-   if (rest_flag == 0)
+   ISR_PROFILE_BEGIN();
+   if (arp[0].rest_flag == 0)
       PORTD ^= ALARM_PIN; //flips the bit, creating a tone
-   if (beat >= max_beat)
-   { //if we've played the note long enough
-      rest_flag = 0;
-      notes++; //move on to the next note
-      //play_song(song, notes);//and play it
+   if (arp[0].beat >= arp[0].max_beat)
+      next_step(0); //if we've played the note long enough
+   ISR_PROFILE_END();
+}
 
-      if (type1 == 1)
-      {
-         uint8_t new = notes_to_play1;
-         if (octave_flag_up1 == 1)
-         {
-            new = (notes_to_play1 & ~(1 << 0));
-         }
-         arpeggiate(notes, new, rate1, octave1, steps1);
-      }
+/*********************************************************************/
+/*                             TIMER3_COMPA                          */
+/*Oscillates pin6, PORTD for the channel 2 tone output               */
+/*********************************************************************/
 
-      else if (type1 == 2)
-      {
-         uint8_t new = notes_to_play1;
-         if (octave_flag_down1 == 1)
-         {
-            new = (notes_to_play1 & ~(1 << 7));
-         }
-         arpeggiateDown(notes, new, rate1, octave1, steps1);
-      }
+ISR(TIMER3_COMPA_vect)
+{
+   ISR_PROFILE_BEGIN();
+   if (arp[1].rest_flag == 0)
+      PORTD ^= ALARM_PIN2;
+   if (arp[1].beat >= arp[1].max_beat)
+      next_step(1);
+   ISR_PROFILE_END();
+}
+#endif
 
-      /*
-      //Arpeggiate up down
-      else if(type1 == 3){                        
-         if((check_notes1(notes_to_play1) && steps1 == 1) || ((notes_to_play1 == 1 || notes_to_play1 == 2 || notes_to_play1 == 4 || notes_to_play1 == 8 || notes_to_play1 == 16 || notes_to_play1 == 32 || notes_to_play1 == 64 || notes_to_play1 == 128) && (steps1 == 1)))           //if less than three notes just play down 
-               arpeggiate(notes, notes_to_play1, rate1, octave1, steps1);
-         else{
-            if(p_flag1 == 1)                  //after completing the run turn flag to zero, initialze the flag when changing to this mode, set it to one. 
-			      arpeggiate(notes, notes_to_play1, rate1, octave1, steps1);        //issue with doing it in function is the above SHIT!!!! we cant skip notes
-            else if(p_flag1 == 0){
-               arpeggiateDown(notes, notes_to_play1, rate1, octave1, steps1);
-            }
-         }
-      }
+/*********************************************************************/
+/*                             music_tempo                           */
+/*Sets the tempo in tenths of a BPM (quarter notes), clamped to      */
+/*TEMPO_MIN - TEMPO_MAX. Takes effect on the next Timer0 tick.       */
+/*********************************************************************/
 
-      //Arpeggiate up down
-      else if(type1 == 4){                        
-         if((check_notes1(notes_to_play1) && steps1 == 1) || ((notes_to_play1 == 1 || notes_to_play1 == 2 || notes_to_play1 == 4 || notes_to_play1 == 8 || notes_to_play1 == 16 || notes_to_play1 == 32 || notes_to_play1 == 64 || notes_to_play1 == 128) && (steps1 == 1)))           //if less than three notes just play down 
-               arpeggiateDown(notes, notes_to_play1, rate1, octave1, steps1);
-         else{
-            if(p_flag1 == 0)                  //after completing the run turn flag to zero, initialze the flag when changing to this mode, set it to one. 
-			      arpeggiateDown(notes, notes_to_play1, rate1, octave1, steps1);
-            else if(p_flag1 == 1){
-               arpeggiate(notes, notes_to_play1, rate1, octave1, steps1);
-            }
-         }
-      }
-*/
+void music_tempo(uint16_t bpm10)
+{
+   uint16_t inc;
+   uint8_t sreg;
+
+   if (bpm10 < TEMPO_MIN)
+      bpm10 = TEMPO_MIN;
+   if (bpm10 > TEMPO_MAX)
+      bpm10 = TEMPO_MAX;
+   tempo = bpm10;
+   inc = CLOCK_INC(bpm10);
+
+   sreg = SREG;
+   cli();
+   clock_inc = inc;
+   SREG = sreg;
+}
 
-      //Arpeggiate up down, chop top and bottom
-      else if (type1 == 3)
-      {
-         if ((check_notes1(notes_to_play1) && steps1 == 1) || ((notes_to_play1 == 1 || notes_to_play1 == 2 || notes_to_play1 == 4 || notes_to_play1 == 8 || notes_to_play1 == 16 || notes_to_play1 == 32 || notes_to_play1 == 64 || notes_to_play1 == 128) && (steps1 == 1))) //if less than three notes just play down
-            arpeggiate(notes, notes_to_play1, rate1, octave1, steps1);
-         else
-         {
-            if (p_flag1 == 1)
-            { //after completing the run turn flag to zero, initialze the flag when changing to this mode, set it to one.
+/*********************************************************************/
+/*                             music_clock                           */
+/*Called from the Timer0 ISR on every overflow. Adds the tempo       */
+/*increment to the clock phase and ticks the beat each time the      */
+/*phase wraps, a 16-bit add and a carry check instead of a modulo.   */
+/*********************************************************************/
 
-               //must go last
-               uint8_t new = notes_to_play1;
-               if (octave_flag_up1 == 1)
-               {
-                  new = (notes_to_play1 & ~(1 << 0));
-               }
+void music_clock(void)
+{
+   uint16_t phase = clock_phase + clock_inc;
 
-               arpeggiate(notes, new, rate1, octave1, steps1);
-            }
-            else if (p_flag1 == 0)
-            {
-               uint8_t new = notes_to_play1;
-
-               if (chop_bot1 == 1)
-               {
-                  new = process_notes_bot1(notes_to_play1);
-                  chop_bot1 = 0;
-               }
-               if (chop_top1 == 1)
-               {
-                  new = process_notes_top1(notes_to_play1);
-                  chop_top1 = 0;
-               }
-               if (octave_flag_down1 == 1)
-               {
-                  new = (new & ~(1 << 7));
-               }
-
-               arpeggiateDown(notes, new, rate1, octave1 - 1, steps1);
-            }
-         }
-      }
+   if (phase < clock_phase)
+      music_tick();
+   clock_phase = phase;
+}
 
-      //Arpeggiate down up, chop top and bottom
-      else if (type1 == 4)
-      {
-         if ((check_notes1(notes_to_play1) && steps1 == 1) || ((notes_to_play1 == 1 || notes_to_play1 == 2 || notes_to_play1 == 4 || notes_to_play1 == 8 || notes_to_play1 == 16 || notes_to_play1 == 32 || notes_to_play1 == 64 || notes_to_play1 == 128) && (steps1 == 1))) //if less than three notes just play down
-            arpeggiateDown(notes, notes_to_play1, rate1, octave1 - 1, steps1);
-         else
-         {
-            if (p_flag1 == 0)
-            { //after completing the run turn flag to zero, initialze the flag when changing to this mode, set it to one.
-               uint8_t new = notes_to_play1;
-               if (octave_flag_down1 == 1)
-               {
-                  new = (notes_to_play1 & ~(1 << 7));
-               }
-               arpeggiateDown(notes, new, rate1, octave1 - 1, steps1);
-            }
-            else if (p_flag1 == 1)
-            {
-               uint8_t new2 = notes_to_play1;
-
-               if (chop_top1 == 1)
-               {
-                  new2 = process_notes_top1(notes_to_play1);
-                  chop_top1 = 0;
-               }
-
-               if (chop_bot1 == 1)
-               {
-                  new2 = process_notes_bot1(notes_to_play1);
-                  chop_bot1 = 0;
-               }
-               if (octave_flag_up1 == 1)
-               {
-                  new2 = (new2 & ~(1 << 0));
-               }
-               arpeggiate(notes, new2, rate1, octave1, steps1);
-            }
-         }
-      }
+/*********************************************************************/
+/*                             music_tick                            */
+/*Called from music_clock() once per beat (64th note), counts the    */
+/*beat of every channel. With TONE_HW or TONE_DDS there are no tone  */
+/*compare ISRs, so this is also the only place the arpeggio steps    */
+/*advance, at the beat rate instead of on every half period of the   */
+/*tone.                                                              */
+/*********************************************************************/
+
+#ifdef TONE_HW
+static void tone_connect(uint8_t ch)
+{
+   //rests disconnect the compare output instead of skipping the toggle
+   if (ch == 0)
+   {
+      if (arp[0].rest_flag)
+         TCCR1A &= ~(1 << COM1C0);
+      else
+         TCCR1A |= (1 << COM1C0);
+   }
+   else
+   {
+      if (arp[1].rest_flag)
+         TCCR3A &= ~(1 << COM3A0);
+      else
+         TCCR3A |= (1 << COM3A0);
    }
 }
+#endif
 
-ISR(TIMER3_COMPA_vect)
+void music_tick(void)
 {
-   if (rest_flag2 == 0)
-      PORTD ^= ALARM_PIN2;
-   if (beat2 >= max_beat2)
-   { //if we've played the note long enough
-      rest_flag2 = 0;
-      notes2++; //move on to the next note
-      //play_song(song, notes);//and play it
-      if (type2 == 1)
-      {
-         uint8_t new = notes_to_play2;
-         if (octave_flag_up2 == 1)
-         {
-            new = (notes_to_play2 & ~(1 << 0));
-         }
-         arpeggiate2(notes2, new, rate2, octave2, steps2);
-      }
+   uint8_t ch;
 
-      else if (type2 == 2)
-      {
-         uint8_t new = notes_to_play2;
-         if (octave_flag_down2 == 1)
-         {
-            new = (notes_to_play2 & ~(1 << 7));
-         }
-         arpeggiateDown2(notes2, new, rate2, octave2, steps2);
-      }
-
-      /*
-            //Arpeggiate up down
-      else if(type2 == 3){                        
-         if((check_notes2(notes_to_play2) && steps2 == 1) || ((notes_to_play2 == 1 || notes_to_play2 == 2 || notes_to_play2 == 4 || notes_to_play2 == 8 || notes_to_play2 == 16 || notes_to_play2 == 32 || notes_to_play2 == 64 || notes_to_play2 == 128) && (steps2 == 1)))           //if less than three notes just play down 
-               arpeggiate2(notes2, notes_to_play2, rate2, octave2, steps2);
-         else{
-            if(p_flag2 == 1)                  //after completing the run turn flag to zero, initialze the flag when changing to this mode, set it to one. 
-			      arpeggiate2(notes2, notes_to_play2, rate2, octave2, steps2);
-            else if(p_flag2 == 0){
-               arpeggiateDown2(notes2, notes_to_play2, rate2, octave2, steps2);
-            }
-         }
-      }
-
-      //Arpeggiate up down
-      else if(type2 == 4){                        
-         if((check_notes2(notes_to_play2) && steps2 == 1) || ((notes_to_play2 == 1 || notes_to_play2 == 2 || notes_to_play2 == 4 || notes_to_play2 == 8 || notes_to_play2 == 16 || notes_to_play2 == 32 || notes_to_play2 == 64 || notes_to_play2 == 128) && (steps2 == 1)))           //if less than three notes just play down 
-               arpeggiateDown2(notes2, notes_to_play2, rate2, octave2, steps2);
-         else{
-            if(p_flag2 == 0)                  //after completing the run turn flag to zero, initialze the flag when changing to this mode, set it to one. 
-               arpeggiateDown2(notes2, notes_to_play2, rate2, octave2, steps2);
-            else if(p_flag2 == 1){
-              arpeggiate2(notes2, notes_to_play2, rate2, octave2, steps2);
-            }
-         }
-      }
-*/
+#ifdef NOTE_TRACE
+   trace_beat++;
+#endif
+   switch (pattern_tick())
+   {
+   case PATTERN_STEP: //hold the channel until music_update() has the step in place
+      seq[SEQUENCER_CH - 1].busy = 1;
+      break;
+   case PATTERN_GATE: //silent until the next step starts
+      play_rest_on(SEQUENCER_CH, 0xFF);
+#ifdef TONE_HW
+      tone_connect(SEQUENCER_CH - 1);
+#endif
+      break;
+   }
 
-      //Arpeggiate up down, chop top and bottom
-      else if (type2 == 3)
-      {
-         if ((check_notes2(notes_to_play2) && steps1 == 2) || ((notes_to_play2 == 1 || notes_to_play2 == 2 || notes_to_play2 == 4 || notes_to_play2 == 8 || notes_to_play2 == 16 || notes_to_play2 == 32 || notes_to_play2 == 64 || notes_to_play2 == 128) && (steps2 == 1))) //if less than three notes just play down
-            arpeggiate2(notes2, notes_to_play2, rate2, octave2, steps2);
-         else
-         {
-            if (p_flag2 == 1)
-            { //after completing the run turn flag to zero, initialze the flag when changing to this mode, set it to one.
-               uint8_t new = notes_to_play2;
-               if (octave_flag_up2 == 1)
-               {
-                  new = (notes_to_play2 & ~(1 << 0));
-               }
-               arpeggiate2(notes2, new, rate2, octave2, steps2);
-            }
-            else if (p_flag2 == 0)
-            {
-               uint8_t new = notes_to_play2;
-
-               if (chop_bot2 == 1)
-               {
-                  new = process_notes_bot2(notes_to_play2);
-                  chop_bot2 = 0;
-               }
-               if (chop_top2 == 1)
-               {
-                  new = process_notes_top2(notes_to_play2);
-                  chop_top2 = 0;
-               }
-               if (octave_flag_down2 == 1)
-               {
-                  new = (new & ~(1 << 7));
-               }
-
-               arpeggiateDown2(notes2, new, rate2, octave2 - 1, steps2);
-            }
-         }
-      }
+   for (ch = 0; ch < ARP_CHANNELS; ch++)
+   {
+      arp_channel_t *c = &arp[ch];
 
-      //Arpeggiate down up, chop top and bottom
-      else if (type2 == 4)
+      c->beat++;
+#ifndef TONE_ISR
+      if (c->beat >= c->max_beat)
       {
-         if ((check_notes2(notes_to_play2) && steps2 == 1) || ((notes_to_play2 == 1 || notes_to_play2 == 2 || notes_to_play2 == 4 || notes_to_play2 == 8 || notes_to_play2 == 16 || notes_to_play2 == 32 || notes_to_play2 == 64 || notes_to_play2 == 128) && (steps2 == 1))) //if less than three notes just play down
-            arpeggiateDown2(notes2, notes_to_play2, rate2, octave2 - 1, steps2);
-         else
-         {
-            if (p_flag2 == 0)
-            { //after completing the run turn flag to zero, initialze the flag when changing to this mode, set it to one.
-               uint8_t new = notes_to_play2;
-               if (octave_flag_down2 == 1)
-               {
-                  new = (notes_to_play2 & ~(1 << 7));
-               }
-               arpeggiateDown2(notes2, new, rate2, octave2 - 1, steps2);
-            }
-            else if (p_flag2 == 1)
-            {
-               uint8_t new2 = notes_to_play2;
-
-               if (chop_top2 == 1)
-               {
-                  new2 = process_notes_top2(notes_to_play2);
-                  chop_top2 = 0;
-               }
-
-               if (chop_bot2 == 1)
-               {
-                  new2 = process_notes_bot2(notes_to_play2);
-                  chop_bot2 = 0;
-               }
-               if (octave_flag_up2 == 1)
-               {
-                  new2 = (new2 & ~(1 << 0));
-               }
-               arpeggiate2(notes2, new2, rate2, octave2, steps2);
-            }
-         }
+         next_step(ch);
+#ifdef TONE_HW
+         tone_connect(ch);
+#endif
       }
+#endif
    }
 }
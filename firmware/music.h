@@ -1,83 +1,208 @@
+//Tone output. By default the Timer1/Timer3 compare ISRs toggle PORTD pins 7
+//and 6 on every half period. Defining TONE_HW (config/hw.h) lets the timers
+//toggle OC1C (PORTB bit 7) and OC3A (PORTE bit 3) in hardware instead, the
+//compare ISRs are not enabled and the steps advance from music_tick().
+//OC1C shares its pin with the Timer2 display dimming output (OC2), so that
+//output is left disconnected in this build. OC3A is also LED 3 of
+//blink_LED(). A rest disconnects the compare output and the pin goes back
+//to PORTE bit 3, so blink_LED() leaves that LED dark and the bit low.
+//Defining TONE_DDS (config/dds.h) replaces both square waves with the
+//polyphonic synthesis engine in synth.c, mixed onto OC3A (PORTE bit 3),
+//which blink_LED() leaves alone here too.
+#if !defined(TONE_HW) && !defined(TONE_DDS)
+#define TONE_ISR
+#endif
+
+//number of notes in a tuning, C0 through B8
+#define NUM_NOTES 108
+
+//steps each channel's compiled arpeggio buffer can hold, the longest
+//pattern (down up over 9 octaves from octave 0 with every key held)
+//needs 191. At most 255, the length is a uint8_t
+#ifndef SEQ_LEN
+#define SEQ_LEN 192
+#endif
+#if SEQ_LEN > 255
+#error "SEQ_LEN does not fit the uint8_t step count"
+#endif
+
+//number of arpeggiator channels. Channel 1 plays on Timer1 and channel 2
+//on Timer3, so more than two needs TONE_DDS where every channel gets its
+//own share of the DDS voices
+#ifndef ARP_CHANNELS
+#define ARP_CHANNELS 2
+#endif
+#if ARP_CHANNELS > 2 && !defined(TONE_DDS)
+#error "ARP_CHANNELS > 2 needs TONE_DDS, see config/dds4.h"
+#endif
+
+//channel (1 based) the pattern sequencer (pattern.h) plays on
+#define SEQUENCER_CH 2
+#if SEQUENCER_CH > ARP_CHANNELS
+#error "SEQUENCER_CH is not one of the ARP_CHANNELS"
+#endif
+
+//one arpeggiator channel
+typedef struct
+{
+   //controls, only written by music_update() from the control events
+   //(event.h), except attribute which is input_task()'s own
+   volatile uint8_t attribute;     //control on the left encoder
+   volatile uint8_t notes_to_play; //one bit per key held
+   volatile uint8_t rate;
+   volatile uint8_t steps;
+   volatile uint8_t octave;
+   volatile uint8_t type;          //1-up, 2-down, 3-up down, 4-down up
+   volatile uint8_t scale;         //index into scale_table in music.c, 0-6 the modes
+   volatile uint8_t root;          //key of the scale, 0-C to 11-B
+   volatile uint8_t step_len;      //16ths a pattern step lasts, SEQUENCER_CH
+   volatile uint8_t wave;          //wavetable, TONE_DDS only
+
+   //playback
+   volatile uint16_t beat;
+   volatile uint16_t max_beat;
+   uint8_t rest_flag;
+   volatile uint8_t accent;        //PAT_ACCENT of the pattern step, TONE_DDS
+} arp_channel_t;
+
+//master clock. Timer0 overflows CLOCK_HZ times a second and the beat is
+//a 64th note, 16 to the quarter. Tempos are in tenths of a BPM
+#define CLOCK_HZ 128 //32.768kHz crystal / 256
+#define TEMPO_MIN 400
+#define TEMPO_MAX 3000
+#define TEMPO_DEFAULT 600 //one beat every 8 Timer0 ticks
+//clock increment per tick, 1/65536ths of a beat. Must stay below 65536,
+//i.e. at most one beat per tick, which holds up to 480 BPM
+#define CLOCK_INC(bpm10) ((uint16_t)((uint32_t)(bpm10) * 16 * 65536 / (600UL * CLOCK_HZ)))
+#if TEMPO_MAX * 16 >= 600 * CLOCK_HZ
+#error "TEMPO_MAX is more than one beat per Timer0 tick"
+#endif
+
 //function prototypes defined here
-extern volatile uint16_t beat;
-extern volatile uint16_t max_beat;
 extern volatile uint8_t  notes;
 
 //global control
 extern volatile uint8_t switch_ch;
+extern arp_channel_t arp[ARP_CHANNELS];
+extern uint16_t tempo; //tenths of a BPM, set with music_tempo()
 
 //control consts ch1 
 extern volatile uint8_t save1;
 extern volatile uint8_t delete1;
 
-//musical consts ch1
-extern volatile uint8_t attribute1;
-extern volatile uint8_t notes_to_play1; 
-extern volatile uint8_t rate1;
-extern volatile uint8_t steps1; 
-extern volatile uint8_t octave1;
-extern volatile uint8_t type1;
-
-//for signaling when to change the up down behavior
-extern volatile uint8_t p_flag1;
-extern volatile uint8_t p_flag2;
-
-/***********************************/
-
-extern volatile uint16_t beat2;
-extern volatile uint16_t max_beat2;
-extern volatile uint8_t  notes2;
-
-//musical consts ch2
-extern volatile uint8_t attribute2;
-extern volatile uint8_t notes_to_play2;
-extern volatile uint8_t rate2;
-extern volatile uint8_t steps2;
-extern volatile uint8_t octave2;
-extern volatile uint8_t repeat2;
-extern volatile uint8_t type2;
-
-//sequence constants
-extern volatile uint8_t play;         
-extern volatile uint8_t stop;        
-extern volatile uint8_t sequence_flag;
-extern volatile uint8_t sequence_to_play[4];
-
-//mode variables
-extern volatile char* mode1;
-extern volatile char* mode1_d;
-extern volatile char* mode2;
-extern volatile char* mode2_d;
-extern volatile uint8_t modal1; 
-extern volatile uint8_t modal2;
-
-extern char C[8]; 
-extern char dorian[8]; 
-extern char phrygian[8]; 
-extern char lydian[8]; 
-extern char mixolydian[8];
-extern char aeolian[8];
-extern char locrian[8];
-
-extern char C_d[8]; 
-extern char dorian_d[8]; 
-extern char phrygian_d[8]; 
-extern char lydian_d[8]; 
-extern char mixolydian_d[8];
-extern char aeolian_d[8];
-extern char locrian_d[8];
-
-void arpeggiate2(uint8_t note, uint8_t notes_to_play, uint8_t duration, uint8_t octave, uint8_t step);
-void arpeggiate(uint8_t note, uint8_t notes, uint8_t duration, uint8_t octave, uint8_t step);
-void song0(uint16_t note); //Beaver Fight Song
-void song1(uint16_t note); //Tetris Theme (A)
-void song2(uint16_t note); //Mario Bros Theme
-void song3(uint16_t note);
+//Scales
+//A scale is a 12 bit mask, bit i set when the note i semitones above the
+//root is in it (bit 0, the root, always is). The 8 keys play the first 8
+//notes of the scale up from the root, so a 7 note scale ends on the root
+//an octave up. The scale and root are resolved to semitones when they
+//change, not on every step.
+#define NUM_SCALES 13
+#define SCALE_USER (NUM_SCALES - 1) //the mask set with music_scale_user()
+
+void music_scale_user(uint16_t mask);
+
+//Tunings
+//A tuning gives every note, C0 to B8, its pitch. tunings.c is written by
+//scl2tune.c from Scala files (make tunings) and holds several, the first
+//12-TET at A4 = 440Hz. For the tone timers a note is a compare value and
+//the clock select (1 clk/1 ... 5 clk/1024) that goes with it, so every
+//note runs at the smallest prescaler it fits under; for TONE_DDS it is a
+//DDS phase increment.
+#ifdef TONE_DDS
+typedef uint16_t tuning_entry_t;
+#else
+typedef struct
+{
+   uint16_t count; //OCRnA
+   uint8_t cs;     //CSn2:0
+} tuning_entry_t;
+#endif
+
+extern const tuning_entry_t *const tuning_table[];
+extern const uint8_t num_tunings;
+extern const tuning_entry_t *tuning; //the one playing, in flash
+
+void music_tuning(uint8_t t);
+
+//Songs
+//A song is an array of two byte events in flash (songs.c), so any event is
+//found in O(1) from its number. The first byte says what the event is:
+//   0-107  play that semitone (see NUM_NOTES), the second byte the duration
+//   0x7F   rest, the second byte the duration
+//   0x80|n jump back to event number byte 2, n more times. There is one
+//          repeat counter, so repeated parts cannot hold another repeat
+//   0xFE   jump to event number byte 2, forever
+//   0xFF   end of the song
+//Durations are in 64th notes, beats of music_tempo(). A song has one
+//array of events for each of channels 1 and 2, each played on its own
+//with song_next(). midi2song.c writes them from MIDI files.
+#define NUM_SONGS 4 //Beaver Fight Song, Tetris Theme (A), Mario Bros Theme, song 3
+#define SONG_REST 0x7F
+#define SONG_REPEAT 0x80
+#define SONG_LOOP 0xFE
+#define SONG_END 0xFF
+
+typedef struct
+{
+   const uint8_t *events[2]; //channels 1 and 2, NULL leaves the channel alone
+   uint8_t len[2];           //events, the END included
+} song_t;
+
+extern const song_t song_table[NUM_SONGS];
+
+void song_seek(uint8_t song, uint8_t channel, uint8_t event);
+uint8_t song_next(uint8_t channel);
 void play_song(uint8_t song, uint8_t note);
 void play_rest(uint8_t duration);
 void play_rest2(uint8_t duration);
+void play_rest_on(uint8_t channel, uint8_t duration);
 void play_note(char note, uint8_t flat, uint8_t octave, uint8_t duration);
+void play_semitone(uint8_t channel, uint8_t n, uint8_t duration);
+uint8_t note_index(char note, uint8_t flat, uint8_t octave);
 void play_note2(char note, uint8_t flat, uint8_t octave, uint8_t duration);
 void music_off(void);
 void music_on(void);
 void music_init(void);
+void music_tick(void);
+void music_tempo(uint16_t bpm10);
+void music_clock(void);
+void music_update(void);
+uint8_t music_pending(void);
+
+//Note trace
+//Building with -DNOTE_TRACE hands every step next_step() plays to
+//note_trace(), which the program the firmware is built into has to supply
+//(arp_render.c records and compares them). beat counts music_tick() calls
+//since reset, so a trace does not move when a step lands elsewhere inside
+//a tone period.
+#ifdef NOTE_TRACE
+#define NOTE_REST 0x01 //rest for the channel rate
+#define NOTE_IDLE 0x02 //one beat rest, no notes held
+
+typedef struct
+{
+   uint32_t beat;
+   uint8_t channel; //0 based
+   uint8_t note;    //semitone, C0 = 0, 0 for rests
+   uint8_t duration;
+   uint8_t flags;   //NOTE_REST or NOTE_IDLE
+} note_event_t;
+
+void note_trace(const note_event_t *e);
+#endif
+
+//Invariant checks
+//Building with -DMUSIC_CHECKS calls music_check_failed() when one of the
+//MUSIC_CHECK() conditions in music.c does not hold. arp_fuzz.c supplies it
+//and aborts, the target build has no checks at all.
+#ifdef MUSIC_CHECKS
+void music_check_failed(const char *cond, int line);
+#define MUSIC_CHECK(cond)                         \
+   do                                             \
+   {                                              \
+      if (!(cond))                                \
+         music_check_failed(#cond, __LINE__);     \
+   } while (0)
+#else
+#define MUSIC_CHECK(cond)
+#endif
@@ -0,0 +1,144 @@
+/*********************************************************************/
+/*                   Pattern sequencer                               */
+/* The steps and the clock that walks through them, see pattern.h.   */
+/* pattern_tick() runs in the Timer0 ISR, everything else from main, */
+/* so the shared state is only written with interrupts off.          */
+/*********************************************************************/
+#include "hal.h"
+#include "music.h"
+#include "pattern.h"
+
+pattern_step_t pattern[PATTERN_STEPS];
+volatile uint8_t pattern_len;
+volatile uint8_t pattern_pos;
+volatile uint8_t pattern_running;
+
+//clock state, pattern_tick() only once running
+static uint8_t pattern_beat;  //beats into the step
+static uint8_t pattern_beats; //beats the step lasts
+static uint8_t pattern_gate;  //beat the gate closes on, past the end when it stays open
+volatile uint8_t pattern_due;
+
+void pattern_init(void)
+{
+   uint8_t n;
+
+   for (n = 0; n < PATTERN_STEPS; n++)
+   {
+      pattern[n].keys = 0;
+      pattern[n].flags = PAT_DEFAULT;
+   }
+   pattern_len = 16;
+   pattern_pos = 0;
+   pattern_running = 0;
+   pattern_due = 0;
+}
+
+void pattern_set(uint8_t n, uint8_t keys, uint8_t flags)
+{
+   //step n, the ISR reads the two bytes as one
+   uint8_t sreg;
+
+   if (n >= PATTERN_STEPS)
+      return;
+   sreg = SREG;
+   cli();
+   pattern[n].keys = keys;
+   pattern[n].flags = flags;
+   SREG = sreg;
+}
+
+void pattern_length(uint8_t len)
+{
+   //clamped to 1 - PATTERN_STEPS, a shorter pattern wraps at its new end
+   if (len < 1)
+      len = 1;
+   if (len > PATTERN_STEPS)
+      len = PATTERN_STEPS;
+   pattern_len = len;
+}
+
+void pattern_start(void)
+{
+   //step 0 starts on the next beat
+   uint8_t sreg;
+
+   sreg = SREG;
+   cli();
+   pattern_pos = pattern_len - 1;
+   pattern_beat = 0;
+   pattern_beats = 1;
+   pattern_gate = 2;
+   pattern_running = 1;
+   SREG = sreg;
+}
+
+void pattern_stop(void)
+{
+   uint8_t sreg;
+
+   sreg = SREG;
+   cli();
+   pattern_running = 0;
+   pattern_due = 0;
+   SREG = sreg;
+}
+
+/*********************************************************************/
+/*                             pattern_tick                          */
+/*Called from music_tick() once a beat. Counts the beats of the step */
+/*playing and moves on to the next one, a handful of 8-bit compares  */
+/*and one multiply per step whatever the pattern holds.              */
+/*********************************************************************/
+
+uint8_t pattern_tick(void)
+{
+   uint8_t pos, next, flags;
+
+   if (!pattern_running)
+      return PATTERN_NONE;
+   if (++pattern_beat < pattern_beats)
+      return pattern_beat == pattern_gate ? PATTERN_GATE : PATTERN_NONE;
+
+   pos = pattern_pos + 1;
+   if (pos >= pattern_len)
+      pos = 0;
+   next = pos + 1;
+   if (next >= pattern_len)
+      next = 0;
+   pattern_pos = pos;
+   pattern_beat = 0;
+
+   //a 16th is 4 beats, gate eighths of that round down to a whole beat
+   pattern_beats = arp[SEQUENCER_CH - 1].step_len << 2;
+   flags = pattern[pos].flags;
+   pattern_gate = (pattern_beats * PAT_GATE_OF(flags)) >> 3;
+   if (pattern_gate == 0)
+      pattern_gate = 1;
+   if (pattern[next].flags & PAT_TIE)
+      pattern_gate = 0xFF; //the gate stays open into the tie
+
+   if (flags & PAT_TIE)
+      return PATTERN_NONE;
+   pattern_due = 1;
+   return PATTERN_STEP;
+}
+
+/*********************************************************************/
+/*                             pattern_take                          */
+/*For music_update(). Copies the step that started since the last    */
+/*call into st and returns 1, or returns 0 when there is none.       */
+/*********************************************************************/
+
+uint8_t pattern_take(pattern_step_t *st)
+{
+   uint8_t sreg, due;
+
+   sreg = SREG;
+   cli();
+   due = pattern_due;
+   pattern_due = 0;
+   *st = pattern[pattern_pos];
+   SREG = sreg;
+   return due;
+}
@@ -0,0 +1,44 @@
+//Pattern sequencer
+//Up to PATTERN_STEPS steps played on SEQUENCER_CH. A step holds the keys
+//the channel arpeggiates for as long as the step lasts, plus a gate,
+//an octave offset, an accent and a tie, packed into two bytes. The steps
+//are advanced by the master clock, pattern_tick() runs from music_tick()
+//once a beat, and music_update() hands each new step to the arpeggio.
+//A step lasts the SEQUENCER_CH step_len control, in 16th notes.
+#define PATTERN_STEPS 32
+#define PATTERN_PAGE 8 //steps a page, one blink_LED() light each (see LED_BITS)
+
+//pattern_step_t flags
+#define PAT_GATE 0x07   //beats the step sounds, eighths of it less one
+#define PAT_OCTAVE 0x38 //octave offset + 4, -4 to +3
+#define PAT_ACCENT 0x40 //louder, TONE_DDS only
+#define PAT_TIE 0x80    //carries on the step before, its keys ignored
+#define PAT_GATE_OF(f) (((f) & PAT_GATE) + 1)
+#define PAT_OCTAVE_OF(f) ((int8_t)(((f) & PAT_OCTAVE) >> 3) - 4)
+#define PAT_FLAGS(gate, octave) ((((gate) - 1) & 0x07) | ((((octave) + 4) & 0x07) << 3))
+#define PAT_DEFAULT PAT_FLAGS(6, 0) //what the panel records
+
+typedef struct
+{
+   uint8_t keys;  //one bit per key, 0 rests for the step
+   uint8_t flags;
+} pattern_step_t;
+
+//what pattern_tick() did on this beat
+#define PATTERN_NONE 0
+#define PATTERN_STEP 1 //a new step, not a tie, starts
+#define PATTERN_GATE 2 //the gate of the step closed
+
+extern pattern_step_t pattern[PATTERN_STEPS];
+extern volatile uint8_t pattern_len;     //steps played, 1 - PATTERN_STEPS
+extern volatile uint8_t pattern_pos;     //step playing
+extern volatile uint8_t pattern_running;
+extern volatile uint8_t pattern_due;     //a step started, until pattern_take()
+
+void pattern_init(void);
+void pattern_set(uint8_t n, uint8_t keys, uint8_t flags);
+void pattern_length(uint8_t len);
+void pattern_start(void);
+void pattern_stop(void);
+uint8_t pattern_tick(void);
+uint8_t pattern_take(pattern_step_t *st);
@@ -0,0 +1,21 @@
+//Interrupt latency profiling
+//Defining ISR_PROFILE (config/profile.h) makes every instrumented ISR
+//record how long it ran in isr_max, the longest any of them has kept
+//interrupts masked since reset. Read it with the debugger. Timer2 counts at
+//clk/64, so the unit is 64 cycles (4us) and anything up to a full Timer2
+//period (1ms) is measured. The register save and restore around the ISR body (a few
+//dozen cycles) is not included.
+#ifdef ISR_PROFILE
+extern volatile uint8_t isr_max;
+#define ISR_PROFILE_BEGIN() uint8_t isr_t0 = TCNT2
+#define ISR_PROFILE_END()                  \
+   do                                      \
+   {                                       \
+      uint8_t isr_t = TCNT2 - isr_t0;      \
+      if (isr_t > isr_max)                 \
+         isr_max = isr_t;                  \
+   } while (0)
+#else
+#define ISR_PROFILE_BEGIN()
+#define ISR_PROFILE_END()
+#endif
@@ -0,0 +1,451 @@
+/*********************************************************************/
+/*                   Scala tuning compiler                           */
+/* Turns Scala scale (.scl) and keyboard mapping (.kbm) files into   */
+/* the tuning tables of tunings.c (see music.h) and reports how far  */
+/* every note ends up from its target pitch. Runs on the build       */
+/* machine (make tunings).                                           */
+/*                                                                   */
+/*  scl2tune [-o tunings.c] [-f f_cpu] [-s rate] [-v]                */
+/*           scale.scl[,map.kbm]...                                  */
+/*    -o  C file to write, default none (report only)                */
+/*    -f  CPU clock the timer counts are for, default 16000000       */
+/*    -s  DDS sample rate the errors are reported at, default 31250  */
+/*        (the table itself is DDS_INC() of the frequency, so it is  */
+/*        right for any DDS_SAMPLE_RATE)                             */
+/*    -v  a report line per note                                     */
+/*                                                                   */
+/* Each scale is one tuning, in the order given. Without a .kbm the  */
+/* scale is laid out from MIDI note 60 (C4) at 261.6256Hz, one key a */
+/* degree, the Scala default. Note n of the tables is MIDI note      */
+/* n + 12. Keys the mapping leaves out play the nearest mapped key   */
+/* below them.                                                       */
+/*                                                                   */
+/* Timers: every note gets the smallest prescaler its compare value  */
+/* fits under, so the count is as large, and the pitch as fine, as   */
+/* the 16-bit timer allows. The report gives the cents error of that */
+/* (timer), of the clk/64 every note used to share (clk/64), and of  */
+/* the DDS phase increment (dds), largest and mean over the notes.   */
+/*********************************************************************/
+#include <ctype.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "music.h"
+
+#define SCL_NOTES 1024
+#define KBM_KEYS 1024
+#define MIDI_C0 12          //MIDI note of note 0 (C0)
+#define TUNE_MAX_HZ 20000.0 //anything higher is left at this
+
+typedef struct
+{
+   char description[512];
+   int notes;
+   double cents[SCL_NOTES + 1]; //cents[0] = 0, cents[notes] the period
+} scl_t;
+
+typedef struct
+{
+   int size, first, last, middle, ref_note, octave_degree;
+   double ref_hz;
+   int map[KBM_KEYS]; //-1 for a key left out
+} kbm_t;
+
+//one note of a tuning
+typedef struct
+{
+   double hz;       //target
+   uint16_t count;  //compare value
+   uint8_t cs;      //clock select, 1 clk/1 ... 5 clk/1024
+   double err;      //cents, timer
+   double err64;    //cents, all at clk/64
+   double err_dds;  //cents, DDS
+} tune_note_t;
+
+static const int prescale[5] = {1, 8, 64, 256, 1024}; //clock selects 1-5
+static double f_cpu = 16000000.0;
+static double dds_rate = 31250.0;
+
+//next line that is not a comment, without the line end. NULL at the end
+static char *next_line(FILE *f, char *line, int size)
+{
+   while (fgets(line, size, f))
+   {
+      if (line[0] == '!')
+         continue;
+      line[strcspn(line, "\r\n")] = 0;
+      return line;
+   }
+   return NULL;
+}
+
+//a pitch line, cents when it has a dot, a ratio or whole number otherwise
+static int scl_pitch(const char *s, double *cents)
+{
+   long a, b = 1;
+   char *end;
+
+   while (isspace((unsigned char)*s))
+      s++;
+   if (strchr(s, '.') && strcspn(s, ".") < strcspn(s, " \t/"))
+   {
+      *cents = strtod(s, &end);
+      return end == s ? -1 : 0;
+   }
+   a = strtol(s, &end, 10);
+   if (end == s)
+      return -1;
+   if (*end == '/')
+   {
+      s = end + 1;
+      b = strtol(s, &end, 10);
+      if (end == s)
+         return -1;
+   }
+   if (a <= 0 || b <= 0)
+      return -1;
+   *cents = 1200.0 * log2((double)a / b);
+   return 0;
+}
+
+static int read_scl(const char *path, scl_t *s)
+{
+   char line[512];
+   FILE *f = fopen(path, "r");
+   int i;
+
+   if (!f)
+   {
+      perror(path);
+      return -1;
+   }
+   s->cents[0] = 0;
+   if (!next_line(f, line, sizeof(line)))
+      goto bad;
+   snprintf(s->description, sizeof(s->description), "%s", line);
+   if (!next_line(f, line, sizeof(line)) || sscanf(line, "%d", &s->notes) != 1 || s->notes < 1 ||
+       s->notes > SCL_NOTES)
+      goto bad;
+   for (i = 1; i <= s->notes; i++)
+      if (!next_line(f, line, sizeof(line)) || scl_pitch(line, &s->cents[i]))
+         goto bad;
+   if (s->cents[s->notes] <= 0)
+      goto bad; //the period has to go up
+   fclose(f);
+   return 0;
+bad:
+   fprintf(stderr, "scl2tune: %s: not a Scala scale file\n", path);
+   fclose(f);
+   return -1;
+}
+
+static int kbm_int(FILE *f, int *v)
+{
+   char line[512];
+
+   return next_line(f, line, sizeof(line)) && sscanf(line, "%d", v) == 1 ? 0 : -1;
+}
+
+static int read_kbm(const char *path, kbm_t *k)
+{
+   char line[512];
+   FILE *f = fopen(path, "r");
+   int i;
+
+   if (!f)
+   {
+      perror(path);
+      return -1;
+   }
+   if (kbm_int(f, &k->size) || k->size < 0 || k->size > KBM_KEYS || kbm_int(f, &k->first) ||
+       kbm_int(f, &k->last) || kbm_int(f, &k->middle) || kbm_int(f, &k->ref_note) ||
+       !next_line(f, line, sizeof(line)) || sscanf(line, "%lf", &k->ref_hz) != 1 || k->ref_hz <= 0 ||
+       kbm_int(f, &k->octave_degree))
+      goto bad;
+   for (i = 0; i < k->size; i++)
+   {
+      if (!next_line(f, line, sizeof(line)))
+         goto bad;
+      if (strchr(line, 'x'))
+         k->map[i] = -1;
+      else if (sscanf(line, "%d", &k->map[i]) != 1)
+         goto bad;
+   }
+   fclose(f);
+   return 0;
+bad:
+   fprintf(stderr, "scl2tune: %s: not a Scala keyboard mapping file\n", path);
+   fclose(f);
+   return -1;
+}
+
+static int floor_div(int a, int b)
+{
+   return a / b - (a % b != 0 && (a < 0) != (b < 0));
+}
+
+//scale degree a key plays, 0 when the mapping leaves it out
+static int key_degree(const kbm_t *k, int key, int *degree)
+{
+   int i, q, r;
+
+   if (key < k->first || key > k->last)
+      return 0;
+   i = key - k->middle;
+   if (!k->size)
+   {
+      *degree = i;
+      return 1;
+   }
+   q = floor_div(i, k->size);
+   r = i - q * k->size;
+   if (k->map[r] < 0)
+      return 0;
+   *degree = k->map[r] + q * k->octave_degree;
+   return 1;
+}
+
+static double degree_cents(const scl_t *s, int degree)
+{
+   int q = floor_div(degree, s->notes), r = degree - q * s->notes;
+
+   return q * s->cents[s->notes] + s->cents[r];
+}
+
+static double cents(double hz, double target)
+{
+   return 1200.0 * log2(hz / target);
+}
+
+//compare value and clock select for hz at the smallest prescaler it fits
+static void tune_timer(tune_note_t *t)
+{
+   double period;
+   uint8_t i;
+
+   for (i = 0; i < 5; i++)
+   {
+      //the ISR or compare output toggles once per count + 1 ticks
+      period = f_cpu / (2.0 * prescale[i] * t->hz);
+      if (period < 65536.5)
+         break;
+   }
+   if (i == 5)
+      i = 4;
+   period = floor(period + 0.5);
+   if (period > 65536)
+      period = 65536;
+   if (period < 2)
+      period = 2;
+   t->count = period - 1;
+   t->cs = i + 1;
+   t->err = cents(f_cpu / (2.0 * prescale[i] * period), t->hz);
+
+   period = floor(f_cpu / (2.0 * 64 * t->hz) + 0.5);
+   if (period > 65536)
+      period = 65536;
+   if (period < 1)
+      period = 1;
+   t->err64 = cents(f_cpu / (2.0 * 64 * period), t->hz);
+}
+
+static void tune_dds(tune_note_t *t)
+{
+   double inc = floor(t->hz * 65536.0 / dds_rate + 0.5);
+
+   if (inc > 32767)
+      inc = 32767;
+   t->err_dds = inc > 0 ? cents(inc * dds_rate / 65536.0, t->hz) : -INFINITY;
+}
+
+//fills the NUM_NOTES notes of a tuning, returns the keys left out
+static int tune(const scl_t *s, const kbm_t *k, tune_note_t *note, int *clamped)
+{
+   double ref;
+   int n, degree, missing = 0, have = 0;
+   double last = 0;
+
+   if (!key_degree(k, k->ref_note, &degree))
+      degree = k->ref_note - k->middle;
+   ref = degree_cents(s, degree);
+   *clamped = 0;
+   for (n = 0; n < NUM_NOTES; n++)
+   {
+      if (key_degree(k, n + MIDI_C0, &degree))
+      {
+         note[n].hz = k->ref_hz * pow(2.0, (degree_cents(s, degree) - ref) / 1200.0);
+         last = note[n].hz;
+         if (!have) //the keys below the first mapped one
+            while (missing)
+               note[n - missing--].hz = last;
+         have = 1;
+      }
+      else
+      {
+         note[n].hz = last; //nearest mapped key below
+         missing++;
+      }
+   }
+   if (!have)
+      return -1;
+   missing = 0;
+   for (n = 0; n < NUM_NOTES; n++)
+   {
+      if (!key_degree(k, n + MIDI_C0, &degree))
+         missing++;
+      if (note[n].hz > TUNE_MAX_HZ)
+      {
+         note[n].hz = TUNE_MAX_HZ;
+         (*clamped)++;
+      }
+      tune_timer(&note[n]);
+      tune_dds(&note[n]);
+   }
+   return missing;
+}
+
+//C identifier from the file name
+static void tuning_name(char *name, size_t size, const char *path)
+{
+   const char *base = strrchr(path, '/');
+   size_t i;
+
+   base = base ? base + 1 : path;
+   for (i = 0; i + 1 < size && base[i] && base[i] != '.' && base[i] != ','; i++)
+      name[i] = isalnum((unsigned char)base[i]) ? tolower((unsigned char)base[i]) : '_';
+   name[i] = 0;
+}
+
+static const char *const note_names[12] = {"C", "Db", "D", "Eb", "E", "F", "Gb", "G", "Ab", "A", "Bb", "B"};
+
+int main(int argc, char **argv)
+{
+   static scl_t scl;
+   static tune_note_t note[NUM_NOTES];
+   static char names[64][48];
+   const char *out_path = NULL;
+   char scl_path[1024], *kbm_path, key[8];
+   double max, max64, max_dds, sum, sum64, sum_dds;
+   int opt, verbose = 0, tunings, t, n, missing, clamped, i;
+   kbm_t kbm;
+   FILE *out = NULL;
+
+   while ((opt = getopt(argc, argv, "o:f:s:v")) != -1)
+   {
+      switch (opt)
+      {
+      case 'o':
+         out_path = optarg;
+         break;
+      case 'f':
+         f_cpu = atof(optarg);
+         break;
+      case 's':
+         dds_rate = atof(optarg);
+         break;
+      case 'v':
+         verbose = 1;
+         break;
+      default:
+         optind = argc;
+         break;
+      }
+   }
+   tunings = argc - optind;
+   if (tunings < 1 || tunings > 64 || f_cpu <= 0 || dds_rate <= 0)
+   {
+      fprintf(stderr, "usage: %s [-o tunings.c] [-f f_cpu] [-s rate] [-v] scale.scl[,map.kbm]...\n", argv[0]);
+      return 1;
+   }
+
+   if (out_path)
+   {
+      out = fopen(out_path, "w");
+      if (!out)
+      {
+         perror(out_path);
+         return 1;
+      }
+      fprintf(out, "/*********************************************************************/\n");
+      fprintf(out, "/*                   Tunings, written by scl2tune                    */\n");
+      fprintf(out, "/* Do not edit, change the Scala files in tunings/ and run make      */\n");
+      fprintf(out, "/* tunings. TUNE() is the timer count and clock select of a note, or */\n");
+      fprintf(out, "/* the DDS phase increment of its frequency in TONE_DDS builds.      */\n");
+      fprintf(out, "/*********************************************************************/\n");
+      fprintf(out, "#include \"hal.h\"\n#include \"music.h\"\n#include \"synth.h\"\n\n");
+      fprintf(out, "#ifdef TONE_DDS\n#define TUNE(count, cs, hz) DDS_INC(hz)\n#else\n");
+      fprintf(out, "#if F_CPU != %.0fUL\n", f_cpu);
+      fprintf(out, "#error \"tunings.c was written for F_CPU %.0f, see scl2tune -f\"\n#endif\n", f_cpu);
+      fprintf(out, "#define TUNE(count, cs, hz) {count, cs}\n#endif\n\n");
+   }
+   printf("%-16s %5s %8s %8s %8s %8s %8s %8s %5s %5s\n", "tuning", "notes", "timer", "mean", "clk/64", "mean", "dds",
+          "mean", "unmap", "clamp");
+
+   for (t = 0; t < tunings; t++)
+   {
+      snprintf(scl_path, sizeof(scl_path), "%s", argv[optind + t]);
+      kbm_path = strchr(scl_path, ',');
+      if (kbm_path)
+         *kbm_path++ = 0;
+      memset(&kbm, 0, sizeof(kbm));
+      kbm.first = 0;
+      kbm.last = 127;
+      kbm.middle = 60;
+      kbm.ref_note = 60;
+      kbm.ref_hz = 261.6255653;
+      if (read_scl(scl_path, &scl) || (kbm_path && read_kbm(kbm_path, &kbm)))
+         return 1;
+      kbm.octave_degree = kbm.octave_degree ? kbm.octave_degree : scl.notes;
+      missing = tune(&scl, &kbm, note, &clamped);
+      if (missing < 0)
+      {
+         fprintf(stderr, "scl2tune: %s maps no key between C0 and B8\n", argv[optind + t]);
+         return 1;
+      }
+      tuning_name(names[t], sizeof(names[t]), scl_path);
+
+      max = max64 = max_dds = sum = sum64 = sum_dds = 0;
+      for (n = 0; n < NUM_NOTES; n++)
+      {
+         max = fmax(max, fabs(note[n].err));
+         max64 = fmax(max64, fabs(note[n].err64));
+         max_dds = fmax(max_dds, fabs(note[n].err_dds));
+         sum += fabs(note[n].err);
+         sum64 += fabs(note[n].err64);
+         sum_dds += fabs(note[n].err_dds);
+      }
+      printf("%-16s %5d %8.3f %8.3f %8.3f %8.3f %8.3f %8.3f %5d %5d\n", names[t], scl.notes, max, sum / NUM_NOTES,
+             max64, sum64 / NUM_NOTES, max_dds, sum_dds / NUM_NOTES, missing, clamped);
+      if (verbose)
+         for (n = 0; n < NUM_NOTES; n++)
+         {
+            snprintf(key, sizeof(key), "%s%d", note_names[n % 12], n / 12);
+            printf("  %-4s %10.4fHz count %5u clk/%-4d %+8.3f  clk/64 %+8.3f  dds %+8.3f\n", key, note[n].hz,
+                   note[n].count, prescale[note[n].cs - 1], note[n].err, note[n].err64, note[n].err_dds);
+         }
+
+      if (out)
+      {
+         fprintf(out, "//%s: %s\n", argv[optind + t], scl.description);
+         fprintf(out, "//largest error %.3f cents on the timers, %.3f on the DDS at %.0fHz\n", max, max_dds, dds_rate);
+         fprintf(out, "static const tuning_entry_t tuning_%s[NUM_NOTES] PROGMEM = {\n", names[t]);
+         for (n = 0; n < NUM_NOTES; n++)
+            fprintf(out, "%s TUNE(%u, %u, %.4f)%s", n % 4 ? "" : "  ", note[n].count, note[n].cs, note[n].hz,
+                    n == NUM_NOTES - 1 ? "\n" : (n % 4 == 3 ? ",\n" : ","));
+         fprintf(out, "};\n\n");
+      }
+   }
+
+   if (out)
+   {
+      fprintf(out, "const tuning_entry_t *const tuning_table[] PROGMEM = {\n");
+      for (i = 0; i < tunings; i++)
+         fprintf(out, "   tuning_%s,\n", names[i]);
+      fprintf(out, "};\n\nconst uint8_t num_tunings PROGMEM = %d;\n", tunings);
+      fclose(out);
+   }
+   return 0;
+}
@@ -0,0 +1,131 @@
+/*********************************************************************/
+/*                   Songs for the music player                      */
+/* Every event is two bytes in flash, see the song format in music.h.*/
+/* song_next() in music.c plays them. To add a song, write its events*/
+/* with the macros below, end it with END (or LOOP) and add it to    */
+/* song_table[] and NUM_SONGS, or convert a MIDI file with midi2song.*/
+/*********************************************************************/
+#include <stddef.h>
+#include "hal.h"
+#include "music.h"
+
+//semitones inside an octave
+#define SONG_C 0
+#define SONG_Db 1
+#define SONG_D 2
+#define SONG_Eb 3
+#define SONG_E 4
+#define SONG_F 5
+#define SONG_Gb 6
+#define SONG_G 7
+#define SONG_Ab 8
+#define SONG_A 9
+#define SONG_Bb 10
+#define SONG_B 11
+
+//durations are in 64th notes, beats of music_tempo(), as for play_note()
+#define NOTE(name, octave, duration) (octave) * 12 + SONG_##name, (duration)
+#define REST(duration) SONG_REST, (duration)
+//play the events from event number from up to here n more times
+#define REPEAT(n, from) SONG_REPEAT | (n), (from)
+#define LOOP(from) SONG_LOOP, (from)
+#define END SONG_END, 0
+
+//beaver fight song (Max and Kellen)
+static const uint8_t song0_events[] PROGMEM = {
+   NOTE(F, 4, 8), NOTE(E, 4, 8), NOTE(D, 4, 8), NOTE(C, 4, 8),
+   NOTE(A, 4, 6), NOTE(Ab, 4, 2), REPEAT(1, 4), NOTE(A, 4, 16),
+   NOTE(F, 4, 8), NOTE(E, 4, 8), NOTE(D, 4, 8), NOTE(C, 4, 8),
+   NOTE(Bb, 4, 6), NOTE(A, 4, 2), REPEAT(1, 12), NOTE(Bb, 4, 16),
+   NOTE(G, 4, 3), REST(1), NOTE(G, 4, 7), REST(1),
+   NOTE(Gb, 4, 4), NOTE(G, 4, 6), NOTE(A, 4, 2), NOTE(Bb, 4, 8),
+   NOTE(A, 4, 2), REST(2), NOTE(A, 4, 8), NOTE(Ab, 4, 4),
+   NOTE(A, 4, 6), NOTE(Bb, 4, 2), NOTE(C, 5, 4), NOTE(Db, 5, 4),
+   NOTE(D, 5, 4), NOTE(B, 4, 8), NOTE(A, 4, 4), NOTE(G, 4, 8),
+   NOTE(A, 4, 8), NOTE(G, 4, 24), REST(8), NOTE(F, 4, 8),
+   NOTE(E, 4, 8), NOTE(D, 4, 8), NOTE(C, 4, 8), NOTE(A, 4, 6),
+   NOTE(Ab, 4, 2), REPEAT(1, 43), NOTE(A, 4, 16), NOTE(F, 4, 8),
+   NOTE(Gb, 4, 8), NOTE(G, 4, 8), NOTE(D, 4, 8), NOTE(Bb, 4, 6),
+   NOTE(A, 4, 2), REPEAT(1, 51), NOTE(Bb, 4, 16), NOTE(D, 4, 16),
+   NOTE(D, 5, 16), NOTE(A, 4, 16), NOTE(C, 5, 16), NOTE(Bb, 4, 8),
+   NOTE(C, 5, 4), NOTE(D, 5, 4), NOTE(A, 4, 8), NOTE(G, 4, 8),
+   NOTE(F, 4, 24), REST(8), END
+};
+
+//tetris theme (A)
+static const uint8_t song1_events[] PROGMEM = {
+   NOTE(E, 4, 8), NOTE(B, 3, 4), NOTE(C, 4, 4), NOTE(D, 4, 4),
+   NOTE(E, 4, 2), NOTE(D, 4, 2), NOTE(C, 4, 4), NOTE(B, 3, 4),
+   NOTE(A, 3, 7), REST(1), NOTE(A, 3, 4), NOTE(C, 4, 4),
+   NOTE(E, 4, 8), NOTE(D, 4, 4), NOTE(C, 4, 4), NOTE(B, 3, 12),
+   NOTE(C, 4, 4), NOTE(D, 4, 8), NOTE(E, 4, 8), NOTE(C, 4, 8),
+   NOTE(A, 3, 7), REST(1), NOTE(A, 3, 16), REST(4),
+   NOTE(D, 4, 8), NOTE(F, 4, 4), NOTE(A, 4, 8), NOTE(G, 4, 4),
+   NOTE(F, 4, 4), NOTE(E, 4, 12), NOTE(C, 4, 4), NOTE(E, 4, 8),
+   NOTE(D, 4, 4), NOTE(C, 4, 4), NOTE(B, 3, 7), REST(1),
+   NOTE(B, 3, 4), NOTE(C, 4, 4), NOTE(D, 4, 8), NOTE(E, 4, 8),
+   NOTE(C, 4, 8), NOTE(A, 3, 7), REST(1), NOTE(A, 3, 8),
+   REST(8), NOTE(E, 3, 16), NOTE(C, 3, 16), NOTE(D, 3, 16),
+   NOTE(B, 2, 16), NOTE(C, 3, 16), NOTE(A, 2, 16), NOTE(Ab, 2, 16),
+   NOTE(B, 2, 8), REST(8), NOTE(E, 3, 16), NOTE(C, 3, 16),
+   NOTE(D, 3, 16), NOTE(B, 2, 16), NOTE(C, 3, 8), NOTE(E, 3, 8),
+   NOTE(A, 3, 16), NOTE(Ab, 3, 16), REST(16), END
+};
+
+//super mario bros
+static const uint8_t song2_events[] PROGMEM = {
+   NOTE(E, 4, 1), REST(1), NOTE(E, 4, 3), REST(1),
+   NOTE(E, 4, 2), REST(2), NOTE(C, 4, 2), NOTE(E, 4, 4),
+   NOTE(G, 4, 8), NOTE(G, 2, 8), REST(8), NOTE(C, 4, 5),
+   NOTE(G, 3, 2), REST(4), NOTE(E, 3, 4), REST(2),
+   NOTE(A, 3, 2), REST(2), NOTE(B, 3, 2), REST(2),
+   NOTE(Bb, 3, 2), NOTE(A, 3, 4), NOTE(G, 3, 3), NOTE(E, 4, 2),
+   REST(1), NOTE(G, 4, 2), NOTE(A, 4, 4), NOTE(F, 4, 2),
+   NOTE(G, 4, 2), REST(2), NOTE(E, 4, 2), REST(2),
+   NOTE(C, 4, 2), NOTE(D, 4, 2), NOTE(B, 3, 2), REST(4),
+   NOTE(C, 4, 5), REST(2), NOTE(G, 3, 2), REST(3),
+   NOTE(E, 3, 4), REST(2), NOTE(A, 3, 2), REST(2),
+   NOTE(B, 3, 2), REST(2), NOTE(Bb, 3, 2), NOTE(A, 3, 4),
+   NOTE(G, 3, 3), NOTE(E, 4, 2), REST(1), NOTE(G, 4, 2),
+   NOTE(A, 4, 4), NOTE(F, 4, 2), NOTE(G, 4, 2), REST(2),
+   NOTE(E, 4, 2), REST(2), NOTE(C, 4, 2), NOTE(D, 4, 2),
+   NOTE(B, 3, 2), REST(8), NOTE(G, 4, 2), NOTE(Gb, 4, 2),
+   NOTE(F, 4, 2), NOTE(Eb, 4, 2), REST(2), NOTE(E, 4, 2),
+   REST(2), NOTE(Ab, 3, 2), NOTE(A, 3, 2), NOTE(C, 4, 2),
+   REST(2), NOTE(A, 3, 2), NOTE(C, 4, 2), NOTE(D, 4, 2),
+   REST(4), NOTE(G, 3, 2), NOTE(Gb, 3, 2), NOTE(F, 3, 2),
+   NOTE(Eb, 3, 2), REST(2), NOTE(E, 3, 2), REST(2),
+   NOTE(G, 4, 2), REST(2), NOTE(G, 4, 1), REST(1),
+   NOTE(G, 4, 4), REST(8), NOTE(G, 4, 2), NOTE(Gb, 4, 2),
+   NOTE(F, 4, 2), NOTE(Eb, 4, 2), REST(2), NOTE(E, 4, 2),
+   REST(2), NOTE(Ab, 3, 2), NOTE(A, 3, 2), NOTE(C, 4, 2),
+   REST(2), NOTE(A, 3, 2), NOTE(C, 4, 2), NOTE(D, 4, 2),
+   REST(4), NOTE(Eb, 4, 4), REST(2), NOTE(D, 4, 2),
+   REST(4), NOTE(C, 4, 4), REST(10), NOTE(C, 4, 2),
+   REST(1), NOTE(C, 4, 2), REST(2), REPEAT(1, 113),
+   NOTE(C, 4, 2), NOTE(D, 4, 4), NOTE(E, 4, 2), NOTE(C, 4, 2),
+   REST(2), NOTE(A, 3, 2), NOTE(G, 3, 4), REST(4),
+   NOTE(C, 4, 2), REST(1), NOTE(C, 4, 2), REST(2),
+   REPEAT(1, 126), NOTE(C, 4, 2), NOTE(D, 4, 2), NOTE(E, 4, 2),
+   REST(16), NOTE(C, 4, 2), REST(1), NOTE(C, 4, 2),
+   REST(2), REPEAT(1, 135), NOTE(C, 4, 2), NOTE(D, 4, 4),
+   NOTE(E, 4, 2), NOTE(C, 4, 2), REST(2), NOTE(A, 3, 2),
+   NOTE(G, 3, 4), REST(8), END
+};
+
+static const uint8_t song3_events[] PROGMEM = {
+   NOTE(E, 4, 7), REST(1), REPEAT(2, 0), NOTE(E, 4, 3),
+   REST(1), NOTE(E, 4, 3), REST(5), NOTE(E, 5, 4),
+   NOTE(Gb, 5, 4), NOTE(E, 5, 4), NOTE(G, 5, 8), NOTE(E, 5, 8),
+   NOTE(Eb, 4, 7), REST(1), REPEAT(2, 12), NOTE(Eb, 4, 3),
+   REST(1), NOTE(Eb, 4, 3), REST(5), NOTE(Eb, 5, 4),
+   NOTE(E, 5, 3), REST(1), NOTE(E, 5, 4), NOTE(Gb, 5, 8),
+   NOTE(E, 5, 8), END
+};
+
+const song_t song_table[NUM_SONGS] PROGMEM = {
+   {{song0_events, NULL}, {sizeof(song0_events) / 2, 0}},
+   {{song1_events, NULL}, {sizeof(song1_events) / 2, 0}},
+   {{song2_events, NULL}, {sizeof(song2_events) / 2, 0}},
+   {{song3_events, NULL}, {sizeof(song3_events) / 2, 0}},
+};
@@ -0,0 +1,43 @@
+/*********************************************************************/
+/*                   SPI transactions for ATMEGA128                  */
+/* One byte transactions, each run to the end with interrupts off.   */
+/* See spi.h for the callbacks.                                      */
+/*********************************************************************/
+#include "hal.h"
+#include "spi.h"
+
+/***********************************************************************/
+//                            spi_init
+//Initalizes the SPI port on the mega128. Does not do any further
+//external device specific initalizations.  Sets up SPI to be:
+//master mode, clock=clk/2, cycle half phase, low polarity, MSB first
+//interrupts disabled, poll SPIF bit in SPSR to check xmit completion
+/***********************************************************************/
+void spi_init(void)
+{
+   SPCR |= (1 << SPE) | (1 << MSTR); //enable SPI, master mode
+   SPSR |= (1 << SPI2X);             // double speed operation
+}
+
+/*********************************************************************/
+/*                             spi_transfer                          */
+/*Runs a transaction: begin, the byte out, end with the byte shifted */
+/*in. Safe from main and from any ISR, interrupts are off for the    */
+/*16 cycles on the bus and the callbacks.                            */
+/*********************************************************************/
+
+void spi_transfer(uint8_t out, spi_begin_t begin, spi_end_t end)
+{
+   uint8_t sreg, in;
+
+   sreg = SREG;
+   cli();
+   if (begin)
+      begin();
+   SPDR = out;
+   loop_until_bit_is_set(SPSR, SPIF);
+   in = SPDR;
+   if (end)
+      end(in);
+   SREG = sreg;
+}
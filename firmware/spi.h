@@ -0,0 +1,19 @@
+//SPI transactions
+//The bargraph (HC595, written from the step logic) and the encoders (HC165,
+//read from the Timer0 ISR) share the SPI port. Every user runs a one byte
+//transaction with interrupts off, so neither can tear the other's.
+//
+//A transaction is one byte out, with an optional begin callback run just
+//before the byte is shifted (chip select, parallel load) and an end
+//callback run with the byte shifted in (latch, deselect, store it). Both run
+//with interrupts off and have to be short.
+//
+//At clk/2 a byte is on the bus for 16 cycles. Waiting for SPIF in place
+//is cheaper than taking SPI_STC_vect for it, which costs about 70 cycles
+//of register saves and callbacks a byte.
+
+typedef void (*spi_begin_t)(void);
+typedef void (*spi_end_t)(uint8_t in);
+
+void spi_init(void);
+void spi_transfer(uint8_t out, spi_begin_t begin, spi_end_t end);
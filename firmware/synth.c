@@ -0,0 +1,202 @@
+/*********************************************************************/
+/*                   DDS synthesis for ATMEGA128                     */
+/* Polyphonic wavetable voices mixed into the Timer3 PWM output.     */
+/* See synth.h for the timer setup and the voice budget.             */
+/*********************************************************************/
+#include "hal.h"
+#include "music.h"
+#include "synth.h"
+
+#ifdef TONE_DDS
+
+#if DDS_VOICES < DDS_CHANNELS
+#error "every arpeggiator channel needs at least one DDS voice"
+#endif
+
+//written from the step logic, read by the sample ISR
+volatile uint16_t phase_inc[DDS_VOICES];
+uint16_t phase[DDS_VOICES];
+const int8_t *volatile voice_wave[DDS_VOICES];
+
+//envelope state, advanced by synth_control() at the Timer0 rate
+//level is 8.8 fixed point, its high byte is the gain the mixer applies
+volatile uint8_t voice_gain[DDS_VOICES];
+uint16_t env_level[DDS_VOICES];
+uint8_t env_stage[DDS_VOICES];
+uint8_t env_accent[DDS_VOICES]; //holds the note at full level instead of the sustain
+
+//envelope settings shared by all voices, rates are per control tick
+uint16_t env_attack = ENV_ATTACK_RATE;
+uint16_t env_decay = ENV_DECAY_RATE;
+uint16_t env_sustain = ENV_SUSTAIN_LEVEL;
+uint16_t env_release = ENV_RELEASE_RATE;
+
+//the voice each channel is currently sounding on
+uint8_t channel_voice[DDS_CHANNELS];
+
+void synth_init(void)
+{
+   uint8_t v;
+
+   for (v = 0; v < DDS_VOICES; v++)
+   {
+      phase_inc[v] = 0;
+      phase[v] = 0;
+      voice_wave[v] = (const int8_t *)pgm_read_ptr(&wave_tables[WAVE_SQUARE]);
+      voice_gain[v] = 0;
+      env_level[v] = 0;
+      env_stage[v] = ENV_OFF;
+      env_accent[v] = 0;
+   }
+   for (v = 0; v < DDS_CHANNELS; v++)
+      channel_voice[v] = v;
+
+   //Timer1 is the sample clock, CTC, no prescale
+   TCCR1A = 0x00;
+   TCCR1B = (1 << WGM12) | (1 << CS10);
+   TCCR1C = 0x00;
+   OCR1A = (F_CPU / DDS_SAMPLE_RATE) - 1;
+   TIMSK |= (1 << OCIE1A);
+
+   //Timer3 is the DAC, 8-bit fast PWM, non-inverting on OC3A, no prescale
+   TCCR3A = (1 << COM3A1) | (1 << WGM30);
+   TCCR3B = (1 << WGM32) | (1 << CS30);
+   TCCR3C = 0x00;
+   OCR3A = 0x80;
+}
+
+void synth_note_on(uint8_t voice, uint8_t n, uint8_t wave, uint8_t accent)
+{
+   uint16_t inc = 0;
+   const int8_t *table;
+   uint8_t sreg;
+
+   if (voice >= DDS_VOICES)
+      return;
+   if (n < NUM_NOTES)
+      inc = pgm_read_word(&tuning[n]);
+   if (wave >= NUM_WAVES)
+      wave = WAVE_SQUARE;
+   table = (const int8_t *)pgm_read_ptr(&wave_tables[wave]);
+
+   //the sample ISR reads these, keep the 16-bit writes atomic
+   sreg = SREG;
+   cli();
+   phase_inc[voice] = inc;
+   voice_wave[voice] = table;
+   //attack starts from the current level so a retriggered voice does not click
+   env_stage[voice] = ENV_ATTACK;
+   env_accent[voice] = accent;
+   SREG = sreg;
+}
+
+void synth_note_off(uint8_t voice)
+{
+   if (voice >= DDS_VOICES)
+      return;
+   if (env_stage[voice] != ENV_OFF)
+      env_stage[voice] = ENV_RELEASE;
+}
+
+/*********************************************************************/
+/*                             synth_play                            */
+/*Starts note n on the next voice owned by the channel (0 based) and */
+/*releases the one it was playing, so the release tail of the old    */
+/*note overlaps the start of the new one. Voice v belongs to channel */
+/*v % DDS_CHANNELS. An accented note does not decay to the sustain.  */
+/*********************************************************************/
+
+void synth_play(uint8_t channel, uint8_t n, uint8_t wave, uint8_t accent)
+{
+   uint8_t v = channel_voice[channel];
+
+   synth_note_off(v);
+   v += DDS_CHANNELS;
+   if (v >= DDS_VOICES)
+      v = channel;
+   channel_voice[channel] = v;
+   synth_note_on(v, n, wave, accent);
+}
+
+void synth_release(uint8_t channel)
+{
+   synth_note_off(channel_voice[channel]);
+}
+
+/*********************************************************************/
+/*                             synth_control                         */
+/*Advances every envelope by one step, called from the Timer0 ISR on */
+/*each overflow (128Hz). 8/16-bit math only, the mixer just picks up */
+/*the new gain byte.                                                 */
+/*********************************************************************/
+
+void synth_control(void)
+{
+   uint8_t v;
+   uint16_t level, sustain;
+
+   for (v = 0; v < DDS_VOICES; v++)
+   {
+      level = env_level[v];
+      switch (env_stage[v])
+      {
+      case ENV_ATTACK:
+         if (level > 0xFFFF - env_attack)
+         {
+            level = 0xFFFF;
+            env_stage[v] = ENV_DECAY;
+         }
+         else
+            level += env_attack;
+         break;
+      case ENV_DECAY:
+         sustain = env_accent[v] ? 0xFFFF : env_sustain;
+         if (level - sustain <= env_decay) //level never drops below sustain here
+         {
+            level = sustain;
+            env_stage[v] = ENV_SUSTAIN;
+         }
+         else
+            level -= env_decay;
+         break;
+      case ENV_RELEASE:
+         if (level <= env_release)
+         {
+            level = 0;
+            env_stage[v] = ENV_OFF;
+         }
+         else
+            level -= env_release;
+         break;
+      }
+      env_level[v] = level;
+      voice_gain[v] = level >> 8;
+   }
+}
+
+/*********************************************************************/
+/*                             TIMER1_COMPA                          */
+/*Sample clock, advances every voice and writes the mix to OCR3A     */
+/*********************************************************************/
+
+ISR(TIMER1_COMPA_vect)
+{
+   uint8_t v;
+   uint8_t gain;
+   int8_t sample;
+   int16_t mix = 0;
+
+   for (v = 0; v < DDS_VOICES; v++)
+   {
+      gain = voice_gain[v];
+      if (gain)
+      { //silent voices are skipped, their phase stops until the next note
+         phase[v] += phase_inc[v];
+         sample = pgm_read_byte(voice_wave[v] + (phase[v] >> 8));
+         mix += ((int16_t)sample * gain) >> 8; //one MULSU on the AVR
+      }
+   }
+   OCR3A = 128 + (mix >> DDS_MIX_SHIFT);
+}
+
+#endif
@@ -0,0 +1,81 @@
+//Direct digital synthesis engine
+//Built when TONE_DDS is defined (config/dds.h). Timer1 runs in CTC mode as a fixed
+//DDS_SAMPLE_RATE sample clock and its compare ISR steps a 16-bit phase
+//accumulator for every voice. The voices are mixed into one 8-bit sample
+//that is written to OCR3A, Timer3 runs as an 8-bit fast PWM (62.5kHz) on
+//OC3A (PORTE bit 3) and acts as the DAC.
+//
+//Every voice reads a 256 entry signed wavetable from flash (wavetable.c)
+//using the high byte of its phase as the index and scales it by the gain of
+//its ADSR envelope. A voice costs one 16-bit add, one flash byte load, one
+//8x8 multiply and one 16-bit add into the mix per sample, so the number of
+//voices is bounded by F_CPU / DDS_SAMPLE_RATE cycles per sample (512 at
+//31.25kHz) minus the ISR entry/exit overhead. The envelopes themselves are
+//stepped at the Timer0 rate in synth_control(), not per sample.
+
+//number of voices, shared out between the arpeggiator channels so that
+//channel n (1 based) owns voices n - 1, n - 1 + DDS_CHANNELS, ...
+#ifndef DDS_VOICES
+#define DDS_VOICES 4
+#endif
+#define DDS_CHANNELS ARP_CHANNELS //from music.h
+
+//sample rate in Hz, anything from about 16kHz to 31.25kHz
+#ifndef DDS_SAMPLE_RATE
+#define DDS_SAMPLE_RATE 31250UL
+#endif
+
+//phase increment for a frequency in Hz, one full cycle is 65536. The
+//tunings in tunings.c are tables of these in TONE_DDS builds, the low
+//notes are coarse (C0 is only 34 counts at 31.25kHz)
+#define DDS_INC(hz) ((uint16_t)((hz) * 65536.0 / DDS_SAMPLE_RATE + 0.5))
+
+//shift that scales the summed voices back into 8 bits
+#if DDS_VOICES <= 1
+#define DDS_MIX_SHIFT 0
+#elif DDS_VOICES <= 2
+#define DDS_MIX_SHIFT 1
+#elif DDS_VOICES <= 4
+#define DDS_MIX_SHIFT 2
+#elif DDS_VOICES <= 8
+#define DDS_MIX_SHIFT 3
+#else
+#define DDS_MIX_SHIFT 4
+#endif
+
+//wavetables, selected per channel with the wave attribute
+#define WAVE_SQUARE 0
+#define WAVE_PULSE25 1
+#define WAVE_PULSE12 2
+#define WAVE_SAW 3
+#define WAVE_TRIANGLE 4
+#define WAVE_SINE 5
+#define NUM_WAVES 6
+
+extern const int8_t *const wave_tables[NUM_WAVES];
+
+//envelope stages
+#define ENV_OFF 0
+#define ENV_ATTACK 1
+#define ENV_DECAY 2
+#define ENV_SUSTAIN 3
+#define ENV_RELEASE 4
+
+//default envelope, levels are 8.8 fixed point and rates are added or
+//subtracted once per Timer0 overflow (7.8ms)
+#define ENV_ATTACK_RATE 0x4000   //full level in 4 ticks, ~31ms
+#define ENV_DECAY_RATE 0x0800    //down to sustain in 8 ticks
+#define ENV_SUSTAIN_LEVEL 0xC000 //75%
+#define ENV_RELEASE_RATE 0x1000  //silent in 12 ticks from sustain
+
+extern uint16_t env_attack;
+extern uint16_t env_decay;
+extern uint16_t env_sustain;
+extern uint16_t env_release;
+
+void synth_init(void);
+void synth_note_on(uint8_t voice, uint8_t n, uint8_t wave, uint8_t accent);
+void synth_note_off(uint8_t voice);
+void synth_play(uint8_t channel, uint8_t n, uint8_t wave, uint8_t accent);
+void synth_release(uint8_t channel);
+void synth_control(void);
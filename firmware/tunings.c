@@ -0,0 +1,155 @@
+/*********************************************************************/
+/*                   Tunings, written by scl2tune                    */
+/* Do not edit, change the Scala files in tunings/ and run make      */
+/* tunings. TUNE() is the timer count and clock select of a note, or */
+/* the DDS phase increment of its frequency in TONE_DDS builds.      */
+/*********************************************************************/
+#include "hal.h"
+#include "music.h"
+#include "synth.h"
+
+#ifdef TONE_DDS
+#define TUNE(count, cs, hz) DDS_INC(hz)
+#else
+#if F_CPU != 16000000UL
+#error "tunings.c was written for F_CPU 16000000, see scl2tune -f"
+#endif
+#define TUNE(count, cs, hz) {count, cs}
+#endif
+
+//tunings/12tet.scl,tunings/12tet.kbm: 12 tone equal temperament, A4 440Hz
+//largest error 0.671 cents on the timers, 22.236 on the DDS at 31250Hz
+static const tuning_entry_t tuning_12tet[NUM_NOTES] PROGMEM = {
+   TUNE(61155, 2, 16.3516), TUNE(57723, 2, 17.3239), TUNE(54483, 2, 18.3540), TUNE(51425, 2, 19.4454),
+   TUNE(48539, 2, 20.6017), TUNE(45814, 2, 21.8268), TUNE(43243, 2, 23.1247), TUNE(40816, 2, 24.4997),
+   TUNE(38525, 2, 25.9565), TUNE(36363, 2, 27.5000), TUNE(34322, 2, 29.1352), TUNE(32395, 2, 30.8677),
+   TUNE(30577, 2, 32.7032), TUNE(28861, 2, 34.6478), TUNE(27241, 2, 36.7081), TUNE(25712, 2, 38.8909),
+   TUNE(24269, 2, 41.2034), TUNE(22907, 2, 43.6535), TUNE(21621, 2, 46.2493), TUNE(20407, 2, 48.9994),
+   TUNE(19262, 2, 51.9131), TUNE(18181, 2, 55.0000), TUNE(17160, 2, 58.2705), TUNE(16197, 2, 61.7354),
+   TUNE(15288, 2, 65.4064), TUNE(14430, 2, 69.2957), TUNE(13620, 2, 73.4162), TUNE(12855, 2, 77.7817),
+   TUNE(12134, 2, 82.4069), TUNE(11453, 2, 87.3071), TUNE(10810, 2, 92.4986), TUNE(10203, 2, 97.9989),
+   TUNE(9630, 2, 103.8262), TUNE(9090, 2, 110.0000), TUNE(8580, 2, 116.5409), TUNE(64792, 1, 123.4708),
+   TUNE(61155, 1, 130.8128), TUNE(57723, 1, 138.5913), TUNE(54483, 1, 146.8324), TUNE(51425, 1, 155.5635),
+   TUNE(48539, 1, 164.8138), TUNE(45814, 1, 174.6141), TUNE(43243, 1, 184.9972), TUNE(40816, 1, 195.9977),
+   TUNE(38525, 1, 207.6523), TUNE(36363, 1, 220.0000), TUNE(34322, 1, 233.0819), TUNE(32395, 1, 246.9417),
+   TUNE(30577, 1, 261.6256), TUNE(28861, 1, 277.1826), TUNE(27241, 1, 293.6648), TUNE(25712, 1, 311.1270),
+   TUNE(24269, 1, 329.6276), TUNE(22907, 1, 349.2282), TUNE(21621, 1, 369.9944), TUNE(20407, 1, 391.9954),
+   TUNE(19262, 1, 415.3047), TUNE(18181, 1, 440.0000), TUNE(17160, 1, 466.1638), TUNE(16197, 1, 493.8833),
+   TUNE(15288, 1, 523.2511), TUNE(14430, 1, 554.3653), TUNE(13620, 1, 587.3295), TUNE(12855, 1, 622.2540),
+   TUNE(12134, 1, 659.2551), TUNE(11453, 1, 698.4565), TUNE(10810, 1, 739.9888), TUNE(10203, 1, 783.9909),
+   TUNE(9630, 1, 830.6094), TUNE(9090, 1, 880.0000), TUNE(8580, 1, 932.3275), TUNE(8098, 1, 987.7666),
+   TUNE(7644, 1, 1046.5023), TUNE(7214, 1, 1108.7305), TUNE(6809, 1, 1174.6591), TUNE(6427, 1, 1244.5079),
+   TUNE(6066, 1, 1318.5102), TUNE(5726, 1, 1396.9129), TUNE(5404, 1, 1479.9777), TUNE(5101, 1, 1567.9817),
+   TUNE(4815, 1, 1661.2188), TUNE(4544, 1, 1760.0000), TUNE(4289, 1, 1864.6550), TUNE(4049, 1, 1975.5332),
+   TUNE(3821, 1, 2093.0045), TUNE(3607, 1, 2217.4610), TUNE(3404, 1, 2349.3181), TUNE(3213, 1, 2489.0159),
+   TUNE(3033, 1, 2637.0205), TUNE(2862, 1, 2793.8259), TUNE(2702, 1, 2959.9554), TUNE(2550, 1, 3135.9635),
+   TUNE(2407, 1, 3322.4376), TUNE(2272, 1, 3520.0000), TUNE(2144, 1, 3729.3101), TUNE(2024, 1, 3951.0664),
+   TUNE(1910, 1, 4186.0090), TUNE(1803, 1, 4434.9221), TUNE(1702, 1, 4698.6363), TUNE(1606, 1, 4978.0317),
+   TUNE(1516, 1, 5274.0409), TUNE(1431, 1, 5587.6517), TUNE(1350, 1, 5919.9108), TUNE(1275, 1, 6271.9270),
+   TUNE(1203, 1, 6644.8752), TUNE(1135, 1, 7040.0000), TUNE(1072, 1, 7458.6202), TUNE(1011, 1, 7902.1328)
+};
+
+//tunings/just.scl: 5-limit just intonation on C, C4 261.6256Hz
+//largest error 0.660 cents on the timers, 19.863 on the DDS at 31250Hz
+static const tuning_entry_t tuning_just[NUM_NOTES] PROGMEM = {
+   TUNE(61155, 2, 16.3516), TUNE(57333, 2, 17.4417), TUNE(54360, 2, 18.3955), TUNE(50962, 2, 19.6219),
+   TUNE(48924, 2, 20.4395), TUNE(45866, 2, 21.8021), TUNE(43488, 2, 22.9944), TUNE(40770, 2, 24.5274),
+   TUNE(38222, 2, 26.1626), TUNE(36693, 2, 27.2527), TUNE(33975, 2, 29.4329), TUNE(32616, 2, 30.6592),
+   TUNE(30577, 2, 32.7032), TUNE(28666, 2, 34.8834), TUNE(27179, 2, 36.7911), TUNE(25481, 2, 39.2438),
+   TUNE(24461, 2, 40.8790), TUNE(22933, 2, 43.6043), TUNE(21743, 2, 45.9889), TUNE(20384, 2, 49.0548),
+   TUNE(19110, 2, 52.3251), TUNE(18346, 2, 54.5053), TUNE(16987, 2, 58.8658), TUNE(16307, 2, 61.3185),
+   TUNE(15288, 2, 65.4064), TUNE(14332, 2, 69.7668), TUNE(13589, 2, 73.5822), TUNE(12740, 2, 78.4877),
+   TUNE(12230, 2, 81.7580), TUNE(11466, 2, 87.2085), TUNE(10871, 2, 91.9777), TUNE(10192, 2, 98.1096),
+   TUNE(9555, 2, 104.6502), TUNE(9172, 2, 109.0107), TUNE(8493, 2, 117.7315), TUNE(65232, 1, 122.6370),
+   TUNE(61155, 1, 130.8128), TUNE(57333, 1, 139.5336), TUNE(54360, 1, 147.1644), TUNE(50962, 1, 156.9753),
+   TUNE(48924, 1, 163.5160), TUNE(45866, 1, 174.4170), TUNE(43488, 1, 183.9555), TUNE(40770, 1, 196.2192),
+   TUNE(38222, 1, 209.3005), TUNE(36693, 1, 218.0213), TUNE(33975, 1, 235.4630), TUNE(32616, 1, 245.2740),
+   TUNE(30577, 1, 261.6256), TUNE(28666, 1, 279.0673), TUNE(27179, 1, 294.3288), TUNE(25481, 1, 313.9507),
+   TUNE(24461, 1, 327.0320), TUNE(22933, 1, 348.8341), TUNE(21743, 1, 367.9110), TUNE(20384, 1, 392.4383),
+   TUNE(19110, 1, 418.6009), TUNE(18346, 1, 436.0426), TUNE(16987, 1, 470.9260), TUNE(16307, 1, 490.5479),
+   TUNE(15288, 1, 523.2511), TUNE(14332, 1, 558.1345), TUNE(13589, 1, 588.6575), TUNE(12740, 1, 627.9014),
+   TUNE(12230, 1, 654.0639), TUNE(11466, 1, 697.6682), TUNE(10871, 1, 735.8219), TUNE(10192, 1, 784.8767),
+   TUNE(9555, 1, 837.2018), TUNE(9172, 1, 872.0852), TUNE(8493, 1, 941.8520), TUNE(8153, 1, 981.0959),
+   TUNE(7644, 1, 1046.5023), TUNE(7166, 1, 1116.2691), TUNE(6794, 1, 1177.3150), TUNE(6369, 1, 1255.8027),
+   TUNE(6115, 1, 1308.1278), TUNE(5732, 1, 1395.3363), TUNE(5435, 1, 1471.6438), TUNE(5095, 1, 1569.7534),
+   TUNE(4777, 1, 1674.4036), TUNE(4586, 1, 1744.1704), TUNE(4246, 1, 1883.7041), TUNE(4076, 1, 1962.1917),
+   TUNE(3821, 1, 2093.0045), TUNE(3582, 1, 2232.5382), TUNE(3397, 1, 2354.6301), TUNE(3184, 1, 2511.6054),
+   TUNE(3057, 1, 2616.2557), TUNE(2866, 1, 2790.6727), TUNE(2717, 1, 2943.2876), TUNE(2547, 1, 3139.5068),
+   TUNE(2388, 1, 3348.8072), TUNE(2292, 1, 3488.3409), TUNE(2122, 1, 3767.4081), TUNE(2038, 1, 3924.3835),
+   TUNE(1910, 1, 4186.0090), TUNE(1791, 1, 4465.0763), TUNE(1698, 1, 4709.2602), TUNE(1592, 1, 5023.2109),
+   TUNE(1528, 1, 5232.5113), TUNE(1432, 1, 5581.3454), TUNE(1358, 1, 5886.5752), TUNE(1273, 1, 6279.0136),
+   TUNE(1193, 1, 6697.6145), TUNE(1146, 1, 6976.6817), TUNE(1061, 1, 7534.8163), TUNE(1018, 1, 7848.7670)
+};
+
+//tunings/pythagorean.scl: Pythagorean, 11 pure fifths up from Eb, C4 261.6256Hz
+//largest error 0.733 cents on the timers, 18.823 on the DDS at 31250Hz
+static const tuning_entry_t tuning_pythagorean[NUM_NOTES] PROGMEM = {
+   TUNE(61155, 2, 16.3516), TUNE(57268, 2, 17.4614), TUNE(54360, 2, 18.3955), TUNE(51599, 2, 19.3797),
+   TUNE(48320, 2, 20.6950), TUNE(45866, 2, 21.8021), TUNE(42951, 2, 23.2819), TUNE(40770, 2, 24.5274),
+   TUNE(38178, 2, 26.1921), TUNE(36240, 2, 27.5933), TUNE(34399, 2, 29.0695), TUNE(32213, 2, 31.0425),
+   TUNE(30577, 2, 32.7032), TUNE(28634, 2, 34.9228), TUNE(27179, 2, 36.7911), TUNE(25799, 2, 38.7593),
+   TUNE(24159, 2, 41.3900), TUNE(22933, 2, 43.6043), TUNE(21475, 2, 46.5637), TUNE(20384, 2, 49.0548),
+   TUNE(19089, 2, 52.3842), TUNE(18119, 2, 55.1866), TUNE(17199, 2, 58.1390), TUNE(16106, 2, 62.0850),
+   TUNE(15288, 2, 65.4064), TUNE(14316, 2, 69.8456), TUNE(13589, 2, 73.5822), TUNE(12899, 2, 77.5187),
+   TUNE(12079, 2, 82.7800), TUNE(11466, 2, 87.2085), TUNE(10737, 2, 93.1275), TUNE(10192, 2, 98.1096),
+   TUNE(9544, 2, 104.7684), TUNE(9059, 2, 110.3733), TUNE(8599, 2, 116.2780), TUNE(64427, 1, 124.1699),
+   TUNE(61155, 1, 130.8128), TUNE(57268, 1, 139.6912), TUNE(54360, 1, 147.1644), TUNE(51599, 1, 155.0374),
+   TUNE(48320, 1, 165.5599), TUNE(45866, 1, 174.4170), TUNE(42951, 1, 186.2549), TUNE(40770, 1, 196.2192),
+   TUNE(38178, 1, 209.5368), TUNE(36240, 1, 220.7466), TUNE(34399, 1, 232.5561), TUNE(32213, 1, 248.3399),
+   TUNE(30577, 1, 261.6256), TUNE(28634, 1, 279.3824), TUNE(27179, 1, 294.3288), TUNE(25799, 1, 310.0747),
+   TUNE(24159, 1, 331.1199), TUNE(22933, 1, 348.8341), TUNE(21475, 1, 372.5098), TUNE(20384, 1, 392.4383),
+   TUNE(19089, 1, 419.0736), TUNE(18119, 1, 441.4931), TUNE(17199, 1, 465.1121), TUNE(16106, 1, 496.6798),
+   TUNE(15288, 1, 523.2511), TUNE(14316, 1, 558.7648), TUNE(13589, 1, 588.6575), TUNE(12899, 1, 620.1495),
+   TUNE(12079, 1, 662.2397), TUNE(11466, 1, 697.6682), TUNE(10737, 1, 745.0197), TUNE(10192, 1, 784.8767),
+   TUNE(9544, 1, 838.1471), TUNE(9059, 1, 882.9863), TUNE(8599, 1, 930.2242), TUNE(8052, 1, 993.3596),
+   TUNE(7644, 1, 1046.5023), TUNE(7158, 1, 1117.5295), TUNE(6794, 1, 1177.3150), TUNE(6449, 1, 1240.2990),
+   TUNE(6039, 1, 1324.4794), TUNE(5732, 1, 1395.3363), TUNE(5368, 1, 1490.0394), TUNE(5095, 1, 1569.7534),
+   TUNE(4771, 1, 1676.2943), TUNE(4529, 1, 1765.9726), TUNE(4299, 1, 1860.4485), TUNE(4026, 1, 1986.7191),
+   TUNE(3821, 1, 2093.0045), TUNE(3578, 1, 2235.0590), TUNE(3397, 1, 2354.6301), TUNE(3224, 1, 2480.5980),
+   TUNE(3019, 1, 2648.9588), TUNE(2866, 1, 2790.6727), TUNE(2683, 1, 2980.0787), TUNE(2547, 1, 3139.5068),
+   TUNE(2385, 1, 3352.5885), TUNE(2264, 1, 3531.9451), TUNE(2149, 1, 3720.8969), TUNE(2012, 1, 3973.4383),
+   TUNE(1910, 1, 4186.0090), TUNE(1789, 1, 4470.1181), TUNE(1698, 1, 4709.2602), TUNE(1612, 1, 4961.1959),
+   TUNE(1509, 1, 5297.9177), TUNE(1432, 1, 5581.3454), TUNE(1341, 1, 5960.1574), TUNE(1273, 1, 6279.0136),
+   TUNE(1192, 1, 6705.1771), TUNE(1132, 1, 7063.8903), TUNE(1074, 1, 7441.7939), TUNE(1006, 1, 7946.8765)
+};
+
+//tunings/meantone.scl: 1/4-comma meantone, Eb to G#, C4 261.6256Hz
+//largest error 0.743 cents on the timers, 15.393 on the DDS at 31250Hz
+static const tuning_entry_t tuning_meantone[NUM_NOTES] PROGMEM = {
+   TUNE(61155, 2, 16.3516), TUNE(58527, 2, 17.0859), TUNE(54699, 2, 18.2816), TUNE(51121, 2, 19.5611),
+   TUNE(48924, 2, 20.4395), TUNE(45724, 2, 21.8699), TUNE(43759, 2, 22.8521), TUNE(40897, 2, 24.4513),
+   TUNE(39139, 2, 25.5494), TUNE(36579, 2, 27.3374), TUNE(34186, 2, 29.2506), TUNE(32717, 2, 30.5642),
+   TUNE(30577, 2, 32.7032), TUNE(29263, 2, 34.1718), TUNE(27349, 2, 36.5633), TUNE(25560, 2, 39.1221),
+   TUNE(24461, 2, 40.8790), TUNE(22861, 2, 43.7399), TUNE(21879, 2, 45.7041), TUNE(20448, 2, 48.9027),
+   TUNE(19569, 2, 51.0987), TUNE(18289, 2, 54.6749), TUNE(17093, 2, 58.5013), TUNE(16358, 2, 61.1284),
+   TUNE(15288, 2, 65.4064), TUNE(14631, 2, 68.3436), TUNE(13674, 2, 73.1266), TUNE(12779, 2, 78.2443),
+   TUNE(12230, 2, 81.7580), TUNE(11430, 2, 87.4798), TUNE(10939, 2, 91.4082), TUNE(10223, 2, 97.8054),
+   TUNE(9784, 2, 102.1975), TUNE(9144, 2, 109.3497), TUNE(8546, 2, 117.0025), TUNE(65435, 1, 122.2567),
+   TUNE(61155, 1, 130.8128), TUNE(58527, 1, 136.6872), TUNE(54699, 1, 146.2531), TUNE(51121, 1, 156.4886),
+   TUNE(48924, 1, 163.5160), TUNE(45724, 1, 174.9596), TUNE(43759, 1, 182.8164), TUNE(40897, 1, 195.6107),
+   TUNE(39139, 1, 204.3950), TUNE(36579, 1, 218.6995), TUNE(34186, 1, 234.0050), TUNE(32717, 1, 244.5134),
+   TUNE(30577, 1, 261.6256), TUNE(29263, 1, 273.3743), TUNE(27349, 1, 292.5063), TUNE(25560, 1, 312.9772),
+   TUNE(24461, 1, 327.0320), TUNE(22861, 1, 349.9191), TUNE(21879, 1, 365.6328), TUNE(20448, 1, 391.2215),
+   TUNE(19569, 1, 408.7899), TUNE(18289, 1, 437.3989), TUNE(17093, 1, 468.0100), TUNE(16358, 1, 489.0268),
+   TUNE(15288, 1, 523.2511), TUNE(14631, 1, 546.7486), TUNE(13674, 1, 585.0125), TUNE(12779, 1, 625.9544),
+   TUNE(12230, 1, 654.0639), TUNE(11430, 1, 699.8382), TUNE(10939, 1, 731.2657), TUNE(10223, 1, 782.4429),
+   TUNE(9784, 1, 817.5799), TUNE(9144, 1, 874.7978), TUNE(8546, 1, 936.0201), TUNE(8179, 1, 978.0537),
+   TUNE(7644, 1, 1046.5023), TUNE(7315, 1, 1093.4973), TUNE(6836, 1, 1170.0251), TUNE(6389, 1, 1251.9087),
+   TUNE(6115, 1, 1308.1278), TUNE(5715, 1, 1399.6765), TUNE(5469, 1, 1462.5314), TUNE(5111, 1, 1564.8859),
+   TUNE(4891, 1, 1635.1598), TUNE(4571, 1, 1749.5956), TUNE(4272, 1, 1872.0402), TUNE(4089, 1, 1956.1073),
+   TUNE(3821, 1, 2093.0045), TUNE(3657, 1, 2186.9945), TUNE(3418, 1, 2340.0502), TUNE(3194, 1, 2503.8174),
+   TUNE(3057, 1, 2616.2556), TUNE(2857, 1, 2799.3530), TUNE(2734, 1, 2925.0627), TUNE(2555, 1, 3129.7718),
+   TUNE(2445, 1, 3270.3196), TUNE(2285, 1, 3499.1912), TUNE(2136, 1, 3744.0803), TUNE(2044, 1, 3912.2147),
+   TUNE(1910, 1, 4186.0090), TUNE(1828, 1, 4373.9890), TUNE(1708, 1, 4680.1004), TUNE(1597, 1, 5007.6348),
+   TUNE(1528, 1, 5232.5113), TUNE(1428, 1, 5598.7059), TUNE(1366, 1, 5850.1255), TUNE(1277, 1, 6259.5435),
+   TUNE(1222, 1, 6540.6391), TUNE(1142, 1, 6998.3824), TUNE(1067, 1, 7488.1606), TUNE(1021, 1, 7824.4294)
+};
+
+const tuning_entry_t *const tuning_table[] PROGMEM = {
+   tuning_12tet,
+   tuning_just,
+   tuning_pythagorean,
+   tuning_meantone,
+};
+
+const uint8_t num_tunings PROGMEM = 4;